@@ -0,0 +1,242 @@
+// Microbenchmarks for the message conversion and logging functions in rerun_ros_interface.
+//
+// All functions log into a recording that is saved to /dev/null, so the numbers include
+// serialization on the Rerun side but no I/O. Besides the time per message, each benchmark
+// reports the heap allocations made from C++ per message. For images, `copies_per_msg` is the
+// number of allocated bytes divided by the size of the image payload, i.e., how many times the
+// image is copied on its way into Rerun. Allocations made by the Rerun SDK itself happen in Rust
+// and are not counted.
+
+#include "rerun_bridge/rerun_ros_interface.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <map>
+#include <new>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <boost/make_shared.hpp>
+#include <sensor_msgs/image_encodings.h>
+
+namespace {
+    std::atomic<size_t> num_allocations{0};
+    std::atomic<size_t> num_allocated_bytes{0};
+} // namespace
+
+void* operator new(std::size_t size) {
+    num_allocations.fetch_add(1, std::memory_order_relaxed);
+    num_allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+namespace {
+    /// Counts the allocations made between construction and `report`.
+    class AllocationCounter {
+      public:
+        AllocationCounter()
+            : _allocations(num_allocations.load()), _allocated_bytes(num_allocated_bytes.load()) {}
+
+        void report(benchmark::State& state, size_t payload_bytes = 0) const {
+            const auto allocations = static_cast<double>(num_allocations.load() - _allocations);
+            const auto bytes = static_cast<double>(num_allocated_bytes.load() - _allocated_bytes);
+            state.counters["allocs_per_msg"] =
+                benchmark::Counter(allocations, benchmark::Counter::kAvgIterations);
+            state.counters["bytes_alloc_per_msg"] =
+                benchmark::Counter(bytes, benchmark::Counter::kAvgIterations);
+            if (payload_bytes > 0) {
+                state.counters["copies_per_msg"] = benchmark::Counter(
+                    bytes / static_cast<double>(payload_bytes),
+                    benchmark::Counter::kAvgIterations
+                );
+                state.SetBytesProcessed(
+                    static_cast<int64_t>(state.iterations() * payload_bytes)
+                );
+            }
+        }
+
+      private:
+        const size_t _allocations;
+        const size_t _allocated_bytes;
+    };
+
+    const rerun::RecordingStream& null_recording() {
+        static const rerun::RecordingStream rec = [] {
+            rerun::RecordingStream rec("rerun_bridge_benchmark");
+            rec.save("/dev/null").exit_on_failure();
+            return rec;
+        }();
+        return rec;
+    }
+
+    const std::vector<std::string> IMAGE_ENCODINGS = {
+        sensor_msgs::image_encodings::RGB8,
+        sensor_msgs::image_encodings::BGR8,
+        sensor_msgs::image_encodings::MONO8,
+        sensor_msgs::image_encodings::TYPE_16UC1,
+        sensor_msgs::image_encodings::TYPE_32FC1,
+    };
+
+    const std::vector<std::pair<int64_t, int64_t>> IMAGE_RESOLUTIONS = {
+        {640, 480},
+        {1280, 720},
+        {1920, 1080},
+    };
+
+    geometry_msgs::TransformStamped make_transform(const std::string& child_frame_id) {
+        geometry_msgs::TransformStamped msg;
+        msg.header.frame_id = "odom";
+        msg.child_frame_id = child_frame_id;
+        msg.transform.translation.x = 1.0;
+        msg.transform.translation.y = 2.0;
+        msg.transform.translation.z = 3.0;
+        msg.transform.rotation.w = 1.0;
+        return msg;
+    }
+
+    sensor_msgs::Image::ConstPtr make_image(const std::string& encoding, int width, int height) {
+        auto msg = boost::make_shared<sensor_msgs::Image>();
+        msg->header.frame_id = "camera";
+        msg->encoding = encoding;
+        msg->width = static_cast<uint32_t>(width);
+        msg->height = static_cast<uint32_t>(height);
+        msg->step = static_cast<uint32_t>(
+            width * sensor_msgs::image_encodings::numChannels(encoding) *
+            sensor_msgs::image_encodings::bitDepth(encoding) / 8
+        );
+        msg->data.assign(static_cast<size_t>(msg->step) * msg->height, 128);
+        return msg;
+    }
+} // namespace
+
+static void BM_log_imu(benchmark::State& state) {
+    auto msg = boost::make_shared<sensor_msgs::Imu>();
+    msg->linear_acceleration.x = 0.1;
+    msg->linear_acceleration.y = 0.2;
+    msg->linear_acceleration.z = 9.81;
+
+    double timestamp = 0.0;
+    AllocationCounter allocations;
+    for (auto _ : state) {
+        log_imu(null_recording(), "/imu", msg, timestamp += 0.001);
+    }
+    allocations.report(state);
+}
+
+BENCHMARK(BM_log_imu);
+
+static void BM_log_image(benchmark::State& state) {
+    const auto& encoding = IMAGE_ENCODINGS[static_cast<size_t>(state.range(0))];
+    const auto msg =
+        make_image(encoding, static_cast<int>(state.range(1)), static_cast<int>(state.range(2)));
+    state.SetLabel(encoding);
+
+    double timestamp = 0.0;
+    AllocationCounter allocations;
+    for (auto _ : state) {
+        log_image(null_recording(), "/camera/image", msg, timestamp += 0.033);
+    }
+    allocations.report(state, msg->data.size());
+}
+
+BENCHMARK(BM_log_image)->Apply([](benchmark::internal::Benchmark* benchmark) {
+    benchmark->ArgNames({"encoding", "width", "height"});
+    for (size_t encoding = 0; encoding < IMAGE_ENCODINGS.size(); ++encoding) {
+        for (const auto& [width, height] : IMAGE_RESOLUTIONS) {
+            benchmark->Args({static_cast<int64_t>(encoding), width, height});
+        }
+    }
+});
+
+static void BM_log_pose_stamped(benchmark::State& state) {
+    auto msg = boost::make_shared<geometry_msgs::PoseStamped>();
+    msg->pose.position.x = 1.0;
+    msg->pose.orientation.w = 1.0;
+
+    double timestamp = 0.0;
+    AllocationCounter allocations;
+    for (auto _ : state) {
+        log_pose_stamped(null_recording(), "/pose", msg, timestamp += 0.01);
+    }
+    allocations.report(state);
+}
+
+BENCHMARK(BM_log_pose_stamped);
+
+static void BM_log_odometry(benchmark::State& state) {
+    auto msg = boost::make_shared<nav_msgs::Odometry>();
+    msg->pose.pose.position.x = 1.0;
+    msg->pose.pose.orientation.w = 1.0;
+
+    double timestamp = 0.0;
+    AllocationCounter allocations;
+    for (auto _ : state) {
+        log_odometry(null_recording(), "/odometry", msg, timestamp += 0.01);
+    }
+    allocations.report(state);
+}
+
+BENCHMARK(BM_log_odometry);
+
+static void BM_log_camera_info(benchmark::State& state) {
+    auto msg = boost::make_shared<sensor_msgs::CameraInfo>();
+    msg->width = 640;
+    msg->height = 480;
+    msg->K = {500.0, 0.0, 320.0, 0.0, 500.0, 240.0, 0.0, 0.0, 1.0};
+
+    double timestamp = 0.0;
+    AllocationCounter allocations;
+    for (auto _ : state) {
+        log_camera_info(null_recording(), "/camera", msg, timestamp += 0.033);
+    }
+    allocations.report(state);
+}
+
+BENCHMARK(BM_log_camera_info);
+
+static void BM_log_tf_message(benchmark::State& state) {
+    const auto num_frames = static_cast<size_t>(state.range(0));
+    std::map<std::string, std::string> tf_frame_to_entity_path;
+    auto msg = boost::make_shared<tf2_msgs::TFMessage>();
+    for (size_t i = 0; i < num_frames; ++i) {
+        const std::string frame = "frame_" + std::to_string(i);
+        tf_frame_to_entity_path[frame] = "/odom/" + frame;
+        msg->transforms.push_back(make_transform(frame));
+    }
+
+    double timestamp = 0.0;
+    AllocationCounter allocations;
+    for (auto _ : state) {
+        log_tf_message(null_recording(), tf_frame_to_entity_path, msg, timestamp += 0.01);
+    }
+    allocations.report(state);
+}
+
+BENCHMARK(BM_log_tf_message)->ArgName("frames")->Arg(1)->Arg(10)->Arg(40);
+
+static void BM_log_transform(benchmark::State& state) {
+    const auto msg = make_transform("body");
+
+    double timestamp = 0.0;
+    AllocationCounter allocations;
+    for (auto _ : state) {
+        log_transform(null_recording(), "/odom/body", msg, timestamp += 0.01);
+    }
+    allocations.report(state);
+}
+
+BENCHMARK(BM_log_transform);
+
+BENCHMARK_MAIN();
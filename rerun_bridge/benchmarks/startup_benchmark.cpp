@@ -0,0 +1,153 @@
+// Startup benchmark for RerunLoggerNode.
+//
+// Publishes an IMU stream (as if a bag was already playing) and then constructs and starts the
+// bridge in the same process. Reports how long the constructor and start() take, the time from
+// constructing the node until the first message is logged, and how many messages were published
+// in the meantime, i.e., were (all but one) missed by the bridge.
+//
+// Without `_yaml_path`, a config with a synthetic TF tree is used. Pass the config of a real
+// robot (e.g., with a URDF) to include its static data. The recording is saved to /dev/null
+// unless `_spawn:=true`, which includes spawning the viewer.
+//
+// Requires a running roscore, e.g.:
+//   rosrun rerun_bridge startup_benchmark _yaml_path:=launch/spot_example_params.yaml
+
+#include "visualizer_node.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <thread>
+
+#include <boost/make_shared.hpp>
+#include <ros/master.h>
+#include <ros/ros.h>
+#include <sensor_msgs/Imu.h>
+#include <yaml-cpp/yaml.h>
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    double milliseconds_since(Clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    /// A tree of the given depth where every frame has `width` children.
+    YAML::Node make_tf_tree(const std::string& parent, int depth, int width) {
+        YAML::Node children(YAML::NodeType::Map);
+        if (depth == 0) {
+            return children;
+        }
+        for (int i = 0; i < width; ++i) {
+            const std::string frame = parent + "_" + std::to_string(i);
+            children[frame] = make_tf_tree(frame, depth - 1, width);
+        }
+        return children;
+    }
+} // namespace
+
+int main(int argc, char** argv) {
+    ros::init(argc, argv, "rerun_bridge_startup_benchmark");
+    if (!ros::master::check()) {
+        ROS_ERROR("The startup benchmark requires a running roscore");
+        return 1;
+    }
+
+    ros::NodeHandle nh;
+    ros::NodeHandle private_nh("~");
+    std::string yaml_path = private_nh.param("yaml_path", std::string());
+    const bool spawn = private_nh.param("spawn", false);
+    const double imu_rate = private_nh.param("imu_rate", 1000.0);
+    const double timeout = private_nh.param("timeout", 30.0);
+
+    if (yaml_path.empty()) {
+        YAML::Node config;
+        config["tf"]["update_rate"] = 30.0;
+        config["tf"]["tree"]["startup"] = make_tf_tree("startup", 4, 4);
+        yaml_path = "/tmp/rerun_bridge_startup_benchmark.yaml";
+        std::ofstream(yaml_path) << config;
+    }
+
+    // The stream is already running when the bridge starts
+    const std::string topic = "/startup_benchmark/imu";
+    auto publisher = nh.advertise<sensor_msgs::Imu>(topic, 1000);
+    std::atomic<bool> running{true};
+    std::atomic<uint64_t> published{0};
+    std::thread publisher_thread([&] {
+        const auto period = std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>(1.0 / imu_rate)
+        );
+        auto next = Clock::now();
+        while (running) {
+            auto msg = boost::make_shared<sensor_msgs::Imu>();
+            msg->header.stamp = ros::Time::now();
+            publisher.publish(msg);
+            published++;
+            next += period;
+            std::this_thread::sleep_until(next);
+        }
+    });
+    std::this_thread::sleep_for(std::chrono::seconds(1));
+
+    ros::NodeHandle bridge_nh("~bridge");
+    bridge_nh.setParam("yaml_path", yaml_path);
+    if (spawn) {
+        bridge_nh.deleteParam("save_path");
+    } else {
+        bridge_nh.setParam("save_path", std::string("/dev/null"));
+    }
+
+    std::atomic<bool> first{true};
+    std::atomic<bool> logged{false};
+    double first_logged_ms = 0.0;
+    uint64_t published_until_logged = 0;
+
+    const uint64_t published_before = published;
+    const auto start = Clock::now();
+    RerunLoggerNode node(bridge_nh);
+    const double constructor_ms = milliseconds_since(start);
+    node.set_message_logged_callback([&](const std::string& logged_topic,
+                                         const ros::Time&,
+                                         double) {
+        if (logged_topic != topic || !first.exchange(false)) {
+            return;
+        }
+        first_logged_ms = milliseconds_since(start);
+        published_until_logged = published - published_before;
+        logged = true;
+    });
+
+    const auto start_start = Clock::now();
+    node.start();
+    const double start_ms = milliseconds_since(start_start);
+    ros::AsyncSpinner spinner(4);
+    spinner.start();
+
+    while (!logged && ros::ok() && milliseconds_since(start) < 1000.0 * timeout) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    std::printf("config:                %s\n", yaml_path.c_str());
+    std::printf("sink:                  %s\n", spawn ? "spawned viewer" : "/dev/null");
+    std::printf("constructor:           %9.2f ms\n", constructor_ms);
+    std::printf("start():               %9.2f ms\n", start_ms);
+    if (logged) {
+        std::printf("first message logged:  %9.2f ms\n", first_logged_ms);
+        std::printf(
+            "published meanwhile:   %9lu (at %.0f Hz)\n",
+            static_cast<unsigned long>(published_until_logged),
+            imu_rate
+        );
+    } else {
+        std::printf("no message logged within %.0f s\n", timeout);
+    }
+    std::fflush(stdout);
+
+    running = false;
+    publisher_thread.join();
+    spinner.stop();
+    node.stop();
+    return logged ? 0 : 1;
+}
@@ -0,0 +1,267 @@
+// End-to-end throughput harness for RerunLoggerNode.
+//
+// Publishes synthetic camera, IMU and TF streams and runs the bridge in the same process, so
+// messages are delivered intra-process. The publish rates are ramped up in steps and for each
+// step the end-to-end latency (message stamp to logged), drop rate, and CPU time spent per topic
+// are reported. The recording is saved to /dev/null.
+//
+// Requires a running roscore (with /use_sim_time unset or false), e.g.:
+//   rosrun rerun_bridge throughput_harness _cameras:=5 _width:=1280 _height:=720 _imu_rate:=1000
+
+#include "visualizer_node.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/make_shared.hpp>
+#include <ros/master.h>
+#include <ros/ros.h>
+#include <sensor_msgs/Image.h>
+#include <sensor_msgs/Imu.h>
+#include <tf2_msgs/TFMessage.h>
+#include <yaml-cpp/yaml.h>
+
+namespace {
+    struct TopicStats {
+        double rate = 0.0; // at 1x load
+        std::atomic<uint64_t> published{0};
+
+        std::mutex mutex;
+        uint64_t logged = 0;
+        double cpu_seconds = 0.0;
+        std::vector<double> latencies;
+    };
+
+    /// Calls `publish` with `base_rate * rate_multiplier` Hz until `running` is false.
+    void publish_loop(
+        double base_rate, const std::atomic<double>& rate_multiplier,
+        const std::atomic<bool>& running, const std::function<void()>& publish
+    ) {
+        auto next = std::chrono::steady_clock::now();
+        while (running) {
+            publish();
+            next += std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                std::chrono::duration<double>(1.0 / (base_rate * rate_multiplier))
+            );
+            std::this_thread::sleep_until(next);
+        }
+    }
+
+    /// A tree of the given depth where every frame has `width` children, below `root`.
+    YAML::Node make_tf_tree(
+        const std::string& parent, int depth, int width, std::vector<std::string>& frames
+    ) {
+        YAML::Node children(YAML::NodeType::Map);
+        if (depth == 0) {
+            return children;
+        }
+        for (int i = 0; i < width; ++i) {
+            const std::string frame = parent + "_" + std::to_string(i);
+            frames.push_back(frame);
+            children[frame] = make_tf_tree(frame, depth - 1, width, frames);
+        }
+        return children;
+    }
+
+    double percentile(const std::vector<double>& sorted, double p) {
+        if (sorted.empty()) {
+            return 0.0;
+        }
+        return sorted[static_cast<size_t>(p * static_cast<double>(sorted.size() - 1))];
+    }
+} // namespace
+
+int main(int argc, char** argv) {
+    ros::init(argc, argv, "rerun_bridge_throughput_harness");
+    if (!ros::master::check()) {
+        ROS_ERROR("The throughput harness requires a running roscore");
+        return 1;
+    }
+
+    ros::NodeHandle nh;
+    ros::NodeHandle private_nh("~");
+    const int cameras = private_nh.param("cameras", 2);
+    const int width = private_nh.param("width", 640);
+    const int height = private_nh.param("height", 480);
+    const double camera_rate = private_nh.param("camera_rate", 30.0);
+    const double imu_rate = private_nh.param("imu_rate", 1000.0);
+    const int tf_depth = private_nh.param("tf_depth", 3);
+    const int tf_width = private_nh.param("tf_width", 3);
+    const double tf_rate = private_nh.param("tf_rate", 50.0);
+    const int ramp_steps = private_nh.param("ramp_steps", 4);
+    const double step_duration = private_nh.param("step_duration", 10.0);
+    const int spinner_threads = private_nh.param("spinner_threads", 8);
+
+    // Bridge config with the synthetic TF tree
+    const std::string root_frame = "harness";
+    std::vector<std::string> frames;
+    YAML::Node config;
+    config["tf"]["update_rate"] = 30.0;
+    config["tf"]["tree"][root_frame] = make_tf_tree(root_frame, tf_depth, tf_width, frames);
+    const std::string yaml_path = "/tmp/rerun_bridge_throughput_harness.yaml";
+    std::ofstream(yaml_path) << config;
+
+    // Topics and publishers
+    std::map<std::string, std::unique_ptr<TopicStats>> stats;
+    std::vector<std::pair<std::string, std::function<void()>>> streams;
+
+    auto add_stream = [&](const std::string& topic, double rate, std::function<void()> publish) {
+        stats[topic] = std::make_unique<TopicStats>();
+        stats[topic]->rate = rate;
+        streams.emplace_back(topic, [&stats, topic, publish = std::move(publish)] {
+            publish();
+            stats.at(topic)->published++;
+        });
+    };
+
+    std::vector<ros::Publisher> publishers;
+    sensor_msgs::Image image_template;
+    image_template.header.frame_id = root_frame;
+    image_template.encoding = "rgb8";
+    image_template.width = static_cast<uint32_t>(width);
+    image_template.height = static_cast<uint32_t>(height);
+    image_template.step = static_cast<uint32_t>(width * 3);
+    image_template.data.assign(static_cast<size_t>(width * height * 3), 128);
+    for (int i = 0; i < cameras; ++i) {
+        const std::string topic = "/harness/camera_" + std::to_string(i) + "/image";
+        publishers.push_back(nh.advertise<sensor_msgs::Image>(topic, 100));
+        add_stream(topic, camera_rate, [publisher = publishers.back(), &image_template] {
+            auto msg = boost::make_shared<sensor_msgs::Image>(image_template);
+            msg->header.stamp = ros::Time::now();
+            publisher.publish(msg);
+        });
+    }
+
+    publishers.push_back(nh.advertise<sensor_msgs::Imu>("/harness/imu", 1000));
+    add_stream("/harness/imu", imu_rate, [publisher = publishers.back()] {
+        auto msg = boost::make_shared<sensor_msgs::Imu>();
+        msg->header.stamp = ros::Time::now();
+        msg->linear_acceleration.z = 9.81;
+        publisher.publish(msg);
+    });
+
+    publishers.push_back(nh.advertise<tf2_msgs::TFMessage>("/tf", 100));
+    add_stream("/tf", tf_rate, [publisher = publishers.back(), &frames, &root_frame] {
+        auto msg = boost::make_shared<tf2_msgs::TFMessage>();
+        const auto now = ros::Time::now();
+        for (const auto& frame : frames) {
+            geometry_msgs::TransformStamped transform;
+            transform.header.stamp = now;
+            transform.header.frame_id = frame.substr(0, frame.rfind('_'));
+            transform.child_frame_id = frame;
+            transform.transform.translation.x = 0.1;
+            transform.transform.rotation.w = 1.0;
+            msg->transforms.push_back(transform);
+        }
+        publisher.publish(msg);
+    });
+
+    // Run the bridge in-process
+    ros::NodeHandle bridge_nh("~bridge");
+    bridge_nh.setParam("yaml_path", yaml_path);
+    bridge_nh.setParam("save_path", std::string("/dev/null"));
+    RerunLoggerNode node(bridge_nh);
+    node.set_message_logged_callback(
+        [&stats](const std::string& topic, const ros::Time& stamp, double cpu_seconds) {
+            auto topic_stats = stats.find(topic);
+            if (topic_stats == stats.end()) {
+                return;
+            }
+            const double latency = (ros::Time::now() - stamp).toSec();
+            std::lock_guard<std::mutex> lock(topic_stats->second->mutex);
+            topic_stats->second->logged++;
+            topic_stats->second->cpu_seconds += cpu_seconds;
+            topic_stats->second->latencies.push_back(latency);
+        }
+    );
+    node.start();
+    ros::AsyncSpinner spinner(static_cast<uint32_t>(spinner_threads));
+    spinner.start();
+
+    std::atomic<bool> running{true};
+    std::atomic<double> rate_multiplier{1.0};
+    std::vector<std::thread> publisher_threads;
+    for (const auto& [topic, publish] : streams) {
+        publisher_threads.emplace_back(
+            publish_loop,
+            stats.at(topic)->rate,
+            std::cref(rate_multiplier),
+            std::cref(running),
+            std::cref(publish)
+        );
+    }
+
+    // give the bridge time to discover all topics
+    std::this_thread::sleep_for(std::chrono::seconds(2));
+
+    for (int step = 1; step <= ramp_steps && ros::ok(); ++step) {
+        rate_multiplier = static_cast<double>(step);
+        for (auto& [topic, topic_stats] : stats) {
+            topic_stats->published = 0;
+            std::lock_guard<std::mutex> lock(topic_stats->mutex);
+            topic_stats->logged = 0;
+            topic_stats->cpu_seconds = 0.0;
+            topic_stats->latencies.clear();
+        }
+
+        std::this_thread::sleep_for(std::chrono::duration<double>(step_duration));
+
+        std::printf("\nStep %d/%d (%.0fx load)\n", step, ramp_steps, rate_multiplier.load());
+        std::printf(
+            "%-30s %9s %10s %10s %8s %8s %8s %8s %8s %7s\n",
+            "topic",
+            "rate[Hz]",
+            "published",
+            "logged",
+            "drop[%]",
+            "p50[ms]",
+            "p90[ms]",
+            "p99[ms]",
+            "max[ms]",
+            "cpu[%]"
+        );
+        for (auto& [topic, topic_stats] : stats) {
+            const auto published = topic_stats->published.load();
+            std::lock_guard<std::mutex> lock(topic_stats->mutex);
+            auto& latencies = topic_stats->latencies;
+            std::sort(latencies.begin(), latencies.end());
+            const double dropped =
+                published > topic_stats->logged
+                    ? static_cast<double>(published - topic_stats->logged) /
+                          static_cast<double>(published)
+                    : 0.0;
+            std::printf(
+                "%-30s %9.1f %10lu %10lu %8.2f %8.2f %8.2f %8.2f %8.2f %7.1f\n",
+                topic.c_str(),
+                topic_stats->rate * step,
+                static_cast<unsigned long>(published),
+                static_cast<unsigned long>(topic_stats->logged),
+                100.0 * dropped,
+                1000.0 * percentile(latencies, 0.5),
+                1000.0 * percentile(latencies, 0.9),
+                1000.0 * percentile(latencies, 0.99),
+                latencies.empty() ? 0.0 : 1000.0 * latencies.back(),
+                100.0 * topic_stats->cpu_seconds / step_duration
+            );
+        }
+        std::fflush(stdout);
+    }
+
+    running = false;
+    for (auto& thread : publisher_threads) {
+        thread.join();
+    }
+    spinner.stop();
+    node.stop();
+    return 0;
+}
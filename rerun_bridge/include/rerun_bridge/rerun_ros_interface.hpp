@@ -9,8 +9,10 @@
 #include <sensor_msgs/CameraInfo.h>
 #include <sensor_msgs/Image.h>
 #include <sensor_msgs/Imu.h>
+#include <sensor_msgs/JointState.h>
 #include <tf2_msgs/TFMessage.h>
 
+#include <opencv2/core.hpp>
 #include <rerun.hpp>
 
 void log_imu(
@@ -23,6 +25,22 @@ void log_image(
     const sensor_msgs::Image::ConstPtr& msg, double normalized_timestamp
 );
 
+// An image decoded into the layout it is logged with, see `convert_image`.
+struct ConvertedImage {
+    cv::Mat image;
+    float meter = 0.0f; // depth value of one meter for depth images, 0 for color images
+};
+
+// Decode an image message, depth images keep their encoding, everything else becomes rgb8.
+// `log_image` is `convert_image` followed by `log_converted_image`, the split allows timing or
+// moving the conversion separately from logging.
+ConvertedImage convert_image(const sensor_msgs::Image::ConstPtr& msg);
+
+void log_converted_image(
+    const rerun::RecordingStream& rec, const std::string& entity_path, const ConvertedImage& image,
+    double normalized_timestamp
+);
+
 void log_pose_stamped(
     const rerun::RecordingStream& rec, const std::string& entity_path,
     const geometry_msgs::PoseStamped::ConstPtr& msg, double normalized_timestamp
@@ -33,11 +51,21 @@ void log_odometry(
     const nav_msgs::Odometry::ConstPtr& msg, double normalized_timestamp
 );
 
+// Logs the position, velocity and effort of each joint as scalars at
+// "<entity_path>/<joint>/{position,velocity,effort}".
+void log_joint_state(
+    const rerun::RecordingStream& rec, const std::string& entity_path,
+    const sensor_msgs::JointState::ConstPtr& msg, double normalized_timestamp
+);
+
 void log_camera_info(
     const rerun::RecordingStream& rec, const std::string& entity_path,
     const sensor_msgs::CameraInfo::ConstPtr& msg, double normalized_timestamp
 );
 
+// Each transform is logged at its own stamp, `normalized_timestamp` is the time of the first one
+// and the others are logged at their offset from it. Consecutive transforms with the same stamp
+// share one timeline update.
 void log_tf_message(
     const rerun::RecordingStream& rec,
     const std::map<std::string, std::string>& tf_frame_to_entity_path,
@@ -48,3 +76,13 @@ void log_transform(
     const rerun::RecordingStream& rec, const std::string& entity_path,
     const geometry_msgs::TransformStamped& msg, double normalized_timestamp
 );
+
+// Convert a transform for logging it at the time the caller has set, e.g., to log all transforms
+// that share a stamp with a single timeline update.
+rerun::Transform3D to_transform3d(const geometry_msgs::Transform& transform);
+
+// Log a transform that never changes (e.g., from /tf_static) once, independent of the timeline.
+void log_static_transform(
+    const rerun::RecordingStream& rec, const std::string& entity_path,
+    const geometry_msgs::TransformStamped& msg
+);
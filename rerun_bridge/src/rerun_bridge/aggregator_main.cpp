@@ -0,0 +1,56 @@
+#include <ros/ros.h>
+#include <rerun.hpp>
+
+#include "shm_log_transport.hpp"
+#include "shm_ring.hpp"
+
+/// Logs everything bridge instances write into a shared memory ring through a single
+/// RecordingStream, see `~shm_name` of the bridge.
+int main(int argc, char** argv) {
+    ros::init(argc, argv, "rerun_bridge_aggregator");
+    ros::NodeHandle nh("~");
+
+    const auto shm_name = nh.param<std::string>("shm_name", "/rerun_bridge");
+    const auto size_mb = nh.param("size_mb", 256);
+    std::string recording_id;
+    nh.getParam("recording_id", recording_id);
+
+    const rerun::RecordingStream rec(
+        "rerun_logger_node",
+        recording_id.empty() ? std::string_view() : std::string_view(recording_id)
+    );
+    std::string save_path;
+    if (nh.getParam("save_path", save_path)) {
+        ROS_INFO("Saving recording to %s", save_path.c_str());
+        rec.save(save_path).exit_on_failure();
+    } else {
+        rec.spawn().exit_on_failure();
+    }
+
+    auto ring = ShmRing::create(shm_name, static_cast<size_t>(size_mb) << 20);
+    ROS_INFO("Created shared memory ring %s with %d MB", shm_name.c_str(), size_mb);
+
+    // NOTE Records from all producers are logged from this one thread, the RecordingStream
+    //   batches them into as few messages to the sink as its flush settings allow.
+    uint64_t dropped = 0;
+    while (ros::ok()) {
+        const size_t consumed = ring->consume(
+            [&](uint32_t kind, const uint8_t* data, size_t size) {
+                log_shm_record(rec, kind, data, size);
+            },
+            1024
+        );
+        if (ring->dropped() != dropped) {
+            dropped = ring->dropped();
+            ROS_WARN_THROTTLE(
+                1.0,
+                "%lu records dropped because the ring was full",
+                static_cast<unsigned long>(dropped)
+            );
+        }
+        if (consumed == 0) {
+            ros::WallDuration(0.0005).sleep();
+        }
+    }
+    return 0;
+}
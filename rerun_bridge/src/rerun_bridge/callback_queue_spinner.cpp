@@ -0,0 +1,74 @@
+#include "callback_queue_spinner.hpp"
+
+#include <algorithm>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+CallbackQueueSpinner::CallbackQueueSpinner(
+    std::string name, const Options& options, const ros::NodeHandle& nh
+)
+    : _name(std::move(name)), _options(options), _nh(nh) {
+    _nh.setCallbackQueue(&_queue);
+}
+
+CallbackQueueSpinner::~CallbackQueueSpinner() {
+    stop();
+}
+
+void CallbackQueueSpinner::start() {
+    if (_running.exchange(true)) {
+        return;
+    }
+    ROS_INFO(
+        "Starting callback queue %s with %zu thread(s)",
+        _name.c_str(),
+        _options.threads
+    );
+    for (size_t i = 0; i < std::max<size_t>(_options.threads, 1); ++i) {
+        _threads.emplace_back([this] { _spin(); });
+        _set_cpu_affinity(_threads.back());
+    }
+}
+
+void CallbackQueueSpinner::stop() {
+    if (!_running.exchange(false)) {
+        return;
+    }
+    for (auto& thread : _threads) {
+        thread.join();
+    }
+    _threads.clear();
+}
+
+void CallbackQueueSpinner::_spin() {
+#ifdef __linux__
+    // name the thread after its queue, shown by tools like top and in traces (max. 15 characters)
+    pthread_setname_np(pthread_self(), _name.substr(0, 15).c_str());
+#endif
+    // the timeout bounds how long stop() waits for an idle queue
+    while (_running && _nh.ok()) {
+        _queue.callAvailable(ros::WallDuration(0.1));
+    }
+}
+
+void CallbackQueueSpinner::_set_cpu_affinity(std::thread& thread) const {
+    if (_options.cpu_affinity.empty()) {
+        return;
+    }
+#ifdef __linux__
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    for (int cpu : _options.cpu_affinity) {
+        CPU_SET(cpu, &cpu_set);
+    }
+    int error = pthread_setaffinity_np(thread.native_handle(), sizeof(cpu_set_t), &cpu_set);
+    if (error != 0) {
+        ROS_WARN("Failed to set CPU affinity for callback queue %s: %d", _name.c_str(), error);
+    }
+#else
+    ROS_WARN_ONCE("CPU affinity for callback queues is only supported on Linux, ignoring it");
+#endif
+}
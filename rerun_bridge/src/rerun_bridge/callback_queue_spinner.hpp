@@ -0,0 +1,48 @@
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <ros/callback_queue.h>
+#include <ros/ros.h>
+
+/// A dedicated callback queue served by its own pool of threads.
+///
+/// Subscribers and timers created through `node_handle()` are dispatched on this queue only,
+/// so expensive callbacks (e.g., image conversion) can't starve cheap, latency sensitive ones
+/// (e.g., TF or IMU) that live on another queue. Unlike ros::AsyncSpinner the threads are owned
+/// here, which allows pinning them to specific CPUs.
+class CallbackQueueSpinner {
+  public:
+    struct Options {
+        size_t threads = 1;
+        /// CPUs the threads may run on, empty means no restriction. Only supported on Linux.
+        std::vector<int> cpu_affinity;
+    };
+
+    CallbackQueueSpinner(std::string name, const Options& options, const ros::NodeHandle& nh);
+    ~CallbackQueueSpinner();
+
+    CallbackQueueSpinner(const CallbackQueueSpinner&) = delete;
+    CallbackQueueSpinner& operator=(const CallbackQueueSpinner&) = delete;
+
+    void start();
+    void stop();
+
+    ros::NodeHandle& node_handle() {
+        return _nh;
+    }
+
+  private:
+    void _spin();
+    void _set_cpu_affinity(std::thread& thread) const;
+
+    const std::string _name;
+    const Options _options;
+    ros::CallbackQueue _queue;
+    ros::NodeHandle _nh;
+    std::atomic<bool> _running{false};
+    std::vector<std::thread> _threads;
+};
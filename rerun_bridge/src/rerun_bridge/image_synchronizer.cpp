@@ -0,0 +1,241 @@
+#include "image_synchronizer.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+ImageSynchronizer::ImageSynchronizer(
+    const Options& options, tf2_ros::Buffer& tf_buffer, const std::string& root_frame,
+    Metrics& metrics, EmitMatch emit
+)
+    : _options(options),
+      _metrics(metrics),
+      _emit(std::move(emit)),
+      _pending_transforms(
+          tf_buffer, root_frame, {options.max_pending_transforms, options.max_delay},
+          [this] {
+              _has_new_transforms = true;
+              _cv.notify_one();
+          }
+      ) {
+    for (size_t i = 0; i < std::max<size_t>(options.emit_threads, 1); ++i) {
+        _lanes.push_back(std::make_unique<EmitLane>());
+        EmitLane& lane = *_lanes.back();
+        lane.thread = std::thread([this, &lane] { _run_lane(lane); });
+    }
+    _worker = std::thread([this] { _run(); });
+}
+
+ImageSynchronizer::~ImageSynchronizer() {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+    }
+    _cv.notify_one();
+    _worker.join();
+    for (auto& lane : _lanes) {
+        {
+            std::lock_guard<std::mutex> lock(lane->mutex);
+            lane->stop = true;
+        }
+        lane->cv.notify_one();
+        lane->thread.join();
+    }
+}
+
+/// Called with `_mutex` held. New streams are assigned to the emit threads round robin.
+ImageSynchronizer::Stream& ImageSynchronizer::_stream(const std::string& name) {
+    auto inserted = _streams.try_emplace(name);
+    if (inserted.second) {
+        inserted.first->second.lane = (_streams.size() - 1) % _lanes.size();
+    }
+    return inserted.first->second;
+}
+
+void ImageSynchronizer::add_image(
+    const std::string& stream, const std::string& topic, const sensor_msgs::Image::ConstPtr& msg,
+    const std::string& entity_path, bool lookup_transform
+) {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        Stream& pending = _stream(stream);
+        auto& images = pending.images;
+        pending.has_images = true;
+        if (images.size() >= _options.max_buffered_images) {
+            ROS_WARN_THROTTLE(1.0, "Image buffer for %s is full, dropping oldest", stream.c_str());
+            const auto& header = images.front().msg->header;
+            _pending_transforms.cancel(header.frame_id, header.stamp);
+            _metrics.topic(images.front().topic).dropped.fetch_add(1, std::memory_order_relaxed);
+            images.pop_front();
+        }
+        images.push_back({msg, topic, entity_path, lookup_transform, Clock::now()});
+        _metrics.topic(topic).queue_depth.store(images.size(), std::memory_order_relaxed);
+        _has_new_messages = true;
+    }
+    _cv.notify_one();
+}
+
+void ImageSynchronizer::add_camera_info(
+    const std::string& stream, const std::string& topic,
+    const sensor_msgs::CameraInfo::ConstPtr& msg, const std::string& entity_path
+) {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto& camera_infos = _stream(stream).camera_infos;
+        if (camera_infos.size() >= 2 * _options.max_buffered_images) {
+            camera_infos.pop_front();
+        }
+        camera_infos.push_back({msg, topic, entity_path, Clock::now()});
+        _has_new_messages = true;
+    }
+    _cv.notify_one();
+}
+
+void ImageSynchronizer::_run() {
+    // NOTE The worker wakes up on new messages and on resolved transforms. The periodic wake up
+    //   is only needed to expire buffered messages (and to catch a transform notification
+    //   that raced with going to sleep, since tf2's callback can't take `_mutex`).
+    const auto expiry_period = std::chrono::milliseconds(50);
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (!_stop) {
+        _cv.wait_for(lock, expiry_period, [this] {
+            return _stop || _has_new_messages || _has_new_transforms.exchange(false);
+        });
+        _has_new_messages = false;
+
+        const auto now = Clock::now();
+        for (auto& [name, stream] : _streams) {
+            _process_stream(stream, now);
+        }
+    }
+}
+
+void ImageSynchronizer::_dispatch(size_t lane_index, Match&& match) {
+    EmitLane& lane = *_lanes[lane_index];
+    {
+        std::lock_guard<std::mutex> lock(lane.mutex);
+        // the emit thread can't keep up, drop the oldest like a full image buffer does
+        if (lane.matches.size() >= _options.max_buffered_images * 2) {
+            const Match& oldest = lane.matches.front();
+            const std::string& topic = oldest.image ? oldest.image_topic : oldest.camera_info_topic;
+            ROS_WARN_THROTTLE(1.0, "Logging can't keep up with %s, dropping oldest", topic.c_str());
+            _metrics.topic(topic).dropped.fetch_add(1, std::memory_order_relaxed);
+            lane.matches.pop_front();
+        }
+        lane.matches.push_back(std::move(match));
+    }
+    lane.cv.notify_one();
+}
+
+void ImageSynchronizer::_run_lane(EmitLane& lane) {
+    std::unique_lock<std::mutex> lock(lane.mutex);
+    while (true) {
+        lane.cv.wait(lock, [&] { return lane.stop || !lane.matches.empty(); });
+        if (lane.stop) {
+            break;
+        }
+        Match match = std::move(lane.matches.front());
+        lane.matches.pop_front();
+        // emit without holding the lock, logging may take a while for large images
+        lock.unlock();
+        _emit(match);
+        lock.lock();
+    }
+}
+
+void ImageSynchronizer::_process_stream(Stream& stream, Clock::time_point now) {
+    const auto max_delay = std::chrono::duration<double>(_options.max_delay);
+    auto expired = [&](Clock::time_point arrival) { return now - arrival > max_delay; };
+
+    // Streams without images (e.g., a lone CameraInfo topic) are forwarded after the delay.
+    if (!stream.has_images) {
+        while (!stream.camera_infos.empty() && expired(stream.camera_infos.front().arrival)) {
+            const auto& camera_info = stream.camera_infos.front();
+            Match match;
+            match.camera_info = camera_info.msg;
+            match.camera_info_topic = camera_info.topic;
+            match.camera_info_entity_path = camera_info.entity_path;
+            _dispatch(stream.lane, std::move(match));
+            stream.camera_infos.pop_front();
+        }
+        return;
+    }
+
+    // Images are emitted strictly in arrival order, an image waiting for its transform or
+    // CameraInfo blocks all later images of the same stream.
+    while (!stream.images.empty()) {
+        const auto& image = stream.images.front();
+        const auto& header = image.msg->header;
+
+        Match match;
+        match.image = image.msg;
+        match.image_topic = image.topic;
+        match.image_entity_path = image.entity_path;
+
+        if (image.lookup_transform) {
+            geometry_msgs::TransformStamped transform;
+            auto status = _pending_transforms.lookup(header.frame_id, header.stamp, transform);
+            if (status == PendingTransformQueue::Status::Available) {
+                match.transform = transform;
+            } else if (status == PendingTransformQueue::Status::Failed || expired(image.arrival)) {
+                _pending_transforms.cancel(header.frame_id, header.stamp);
+                _metrics.count_tf_failure(
+                    status == PendingTransformQueue::Status::Failed ? TfFailure::Lookup
+                                                                     : TfFailure::Timeout
+                );
+                auto& metrics = _metrics.topic(image.topic);
+                metrics.dropped.fetch_add(1, std::memory_order_relaxed);
+                metrics.queue_depth.store(stream.images.size() - 1, std::memory_order_relaxed);
+                ROS_WARN_THROTTLE(
+                    1.0,
+                    "Dropping image on %s, no transform for frame %s at %.6f",
+                    image.entity_path.c_str(),
+                    header.frame_id.c_str(),
+                    header.stamp.toSec()
+                );
+                stream.images.pop_front();
+                continue;
+            } else {
+                break;
+            }
+        }
+
+        const PendingCameraInfo* nearest = nullptr;
+        double nearest_dt = _options.camera_info_tolerance;
+        bool newer_camera_info = false;
+        for (const auto& camera_info : stream.camera_infos) {
+            const double dt = (camera_info.msg->header.stamp - header.stamp).toSec();
+            newer_camera_info |= dt >= 0.0;
+            if (std::abs(dt) <= nearest_dt) {
+                nearest = &camera_info;
+                nearest_dt = std::abs(dt);
+            }
+        }
+
+        // a closer CameraInfo may still arrive, wait for it unless the image is about to expire
+        if (nearest == nullptr && !stream.camera_infos.empty() && !newer_camera_info &&
+            !expired(image.arrival)) {
+            break;
+        }
+
+        if (nearest != nullptr) {
+            match.camera_info = nearest->msg;
+            match.camera_info_topic = nearest->topic;
+            match.camera_info_entity_path = nearest->entity_path;
+        }
+
+        const ros::Time emitted_stamp = header.stamp;
+        _metrics.topic(image.topic).queue_depth.store(
+            stream.images.size() - 1, std::memory_order_relaxed
+        );
+        _dispatch(stream.lane, std::move(match));
+        stream.images.pop_front();
+
+        // CameraInfos older than the emitted image can't be matched anymore
+        while (!stream.camera_infos.empty() &&
+               (emitted_stamp - stream.camera_infos.front().msg->header.stamp).toSec() >
+                   _options.camera_info_tolerance) {
+            stream.camera_infos.pop_front();
+        }
+    }
+}
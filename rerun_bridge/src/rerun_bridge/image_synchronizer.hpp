@@ -0,0 +1,137 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <geometry_msgs/TransformStamped.h>
+#include <ros/ros.h>
+#include <sensor_msgs/CameraInfo.h>
+#include <sensor_msgs/Image.h>
+#include <tf2_ros/buffer.h>
+
+#include "metrics.hpp"
+#include "pending_transform_queue.hpp"
+
+/// Pairs images with the nearest CameraInfo and (optionally) their transform to the root frame.
+///
+/// Subscriber callbacks only push messages into per-stream buffers. A single worker thread
+/// matches them, so no spinner thread ever waits for TF, and hands complete sets to a pool of
+/// emit threads that convert and log them. Each stream is assigned to one emit thread, which
+/// keeps its order while different cameras are logged in parallel. Missing transforms are
+/// resolved through a PendingTransformQueue that wakes the worker once tf2 has the data. Images
+/// whose transform does not become available within `max_delay` are dropped. Drops and the
+/// number of buffered images are reported to `metrics`.
+class ImageSynchronizer {
+  public:
+    struct Options {
+        /// Maximum stamp difference between an image and its CameraInfo.
+        double camera_info_tolerance = 0.02;
+        /// Maximum wall time an image (or unmatched CameraInfo) waits in the buffer.
+        double max_delay = 0.5;
+        /// Maximum number of buffered images per stream, older images are dropped first.
+        size_t max_buffered_images = 10;
+        /// Maximum number of outstanding transform lookups over all streams.
+        size_t max_pending_transforms = 100;
+        /// Number of threads calling the emit callback.
+        size_t emit_threads = 4;
+    };
+
+    struct Match {
+        sensor_msgs::Image::ConstPtr image; // null for CameraInfo-only streams
+        std::string image_topic;
+        std::string image_entity_path;
+        sensor_msgs::CameraInfo::ConstPtr camera_info;
+        std::string camera_info_topic;
+        std::string camera_info_entity_path;
+        std::optional<geometry_msgs::TransformStamped> transform;
+    };
+
+    using EmitMatch = std::function<void(const Match& match)>;
+
+    /// Transforms are looked up from the image frame into `root_frame`.
+    ImageSynchronizer(
+        const Options& options, tf2_ros::Buffer& tf_buffer, const std::string& root_frame,
+        Metrics& metrics, EmitMatch emit
+    );
+    ~ImageSynchronizer();
+
+    ImageSynchronizer(const ImageSynchronizer&) = delete;
+    ImageSynchronizer& operator=(const ImageSynchronizer&) = delete;
+
+    /// Streams are identified by the namespace shared by an image topic and its CameraInfo.
+    void add_image(
+        const std::string& stream, const std::string& topic,
+        const sensor_msgs::Image::ConstPtr& msg, const std::string& entity_path,
+        bool lookup_transform
+    );
+    void add_camera_info(
+        const std::string& stream, const std::string& topic,
+        const sensor_msgs::CameraInfo::ConstPtr& msg, const std::string& entity_path
+    );
+
+  private:
+    using Clock = std::chrono::steady_clock;
+
+    struct PendingImage {
+        sensor_msgs::Image::ConstPtr msg;
+        std::string topic;
+        std::string entity_path;
+        bool lookup_transform;
+        Clock::time_point arrival;
+    };
+
+    struct PendingCameraInfo {
+        sensor_msgs::CameraInfo::ConstPtr msg;
+        std::string topic;
+        std::string entity_path;
+        Clock::time_point arrival;
+    };
+
+    struct Stream {
+        std::deque<PendingImage> images;
+        std::deque<PendingCameraInfo> camera_infos; // sorted by arrival, i.e., roughly by stamp
+        bool has_images = false;
+        size_t lane = 0; // emit thread
+    };
+
+    /// Matches of the streams assigned to one emit thread, in order.
+    struct EmitLane {
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::deque<Match> matches;
+        bool stop = false;
+        std::thread thread;
+    };
+
+    Stream& _stream(const std::string& name);
+    void _run();
+    void _process_stream(Stream& stream, Clock::time_point now);
+    void _dispatch(size_t lane, Match&& match);
+    void _run_lane(EmitLane& lane);
+
+    const Options _options;
+    Metrics& _metrics;
+    const EmitMatch _emit;
+
+    std::mutex _mutex;
+    std::condition_variable _cv;
+    std::map<std::string, Stream> _streams;
+    bool _stop = false;
+    bool _has_new_messages = false;
+    // set from within tf2's callback, which must not acquire `_mutex`
+    std::atomic<bool> _has_new_transforms{false};
+
+    PendingTransformQueue _pending_transforms;
+    std::vector<std::unique_ptr<EmitLane>> _lanes;
+    std::thread _worker;
+};
@@ -0,0 +1,58 @@
+#include "joint_state_logger.hpp"
+
+#include <unordered_map>
+
+JointStateLogger::JointStateLogger(std::string entity_path, const UrdfKinematics* kinematics)
+    : _entity_path(std::move(entity_path)), _kinematics(kinematics) {}
+
+void JointStateLogger::log_scalars(
+    const rerun::RecordingStream& rec, const sensor_msgs::JointState& msg,
+    double normalized_timestamp
+) {
+    _update_joints(msg.name);
+
+    // NOTE the position, velocity and effort arrays are either empty or as long as the names
+    auto log = [&](const std::string& entity_path, const std::vector<double>& values, size_t i) {
+        if (i >= values.size()) {
+            return;
+        }
+        rec.log(entity_path, rerun::Scalar(values[i]));
+    };
+
+    rec.set_time_seconds("timestamp", normalized_timestamp);
+    for (size_t i = 0; i < _joint_entity_paths.size(); ++i) {
+        const auto& entity_paths = _joint_entity_paths[i];
+        log(entity_paths.position, msg.position, i);
+        log(entity_paths.velocity, msg.velocity, i);
+        log(entity_paths.effort, msg.effort, i);
+    }
+}
+
+void JointStateLogger::_update_joints(const std::vector<std::string>& names) {
+    if (names == _names) {
+        return;
+    }
+    _names = names;
+
+    _joint_entity_paths.clear();
+    std::unordered_map<std::string, size_t> name_to_index;
+    for (size_t i = 0; i < names.size(); ++i) {
+        const std::string joint_entity_path = _entity_path + "/" + names[i];
+        _joint_entity_paths.push_back(
+            {joint_entity_path + "/position",
+             joint_entity_path + "/velocity",
+             joint_entity_path + "/effort"}
+        );
+        name_to_index[names[i]] = i;
+    }
+
+    _links.clear();
+    if (_kinematics) {
+        for (const auto& joint : _kinematics->joints()) {
+            auto index = name_to_index.find(joint.position_joint);
+            if (index != name_to_index.end()) {
+                _links.push_back({&joint, index->second});
+            }
+        }
+    }
+}
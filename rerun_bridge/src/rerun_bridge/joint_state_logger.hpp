@@ -0,0 +1,66 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <geometry_msgs/TransformStamped.h>
+#include <rerun.hpp>
+#include <sensor_msgs/JointState.h>
+
+#include "urdf_kinematics.hpp"
+
+/// Logs the JointState messages of a single topic.
+///
+/// Positions, velocities and efforts are logged as scalars at
+/// "<entity_path>/<joint>/{position,velocity,effort}". The entity paths and the message index of
+/// each joint with a link transform are cached until the topic's joint names change, so logging
+/// a message neither builds strings nor looks up names. Not thread-safe, which is fine since
+/// roscpp never runs the callbacks of one subscription concurrently.
+class JointStateLogger {
+  public:
+    /// Link transforms are only computed if `kinematics` is set, it must outlive the logger.
+    JointStateLogger(std::string entity_path, const UrdfKinematics* kinematics);
+
+    void log_scalars(
+        const rerun::RecordingStream& rec, const sensor_msgs::JointState& msg,
+        double normalized_timestamp
+    );
+
+    /// Call `visit(entity_path, transform)` for the link transform of each known joint.
+    template <typename TVisit>
+    void for_each_link_transform(const sensor_msgs::JointState& msg, TVisit&& visit) {
+        _update_joints(msg.name);
+        for (const auto& link : _links) {
+            if (link.position_index >= msg.position.size()) {
+                continue;
+            }
+            const double position =
+                link.joint->multiplier * msg.position[link.position_index] + link.joint->offset;
+            _transform.header.stamp = msg.header.stamp;
+            _transform.transform = UrdfKinematics::transform(*link.joint, position);
+            visit(link.joint->entity_path, _transform);
+        }
+    }
+
+  private:
+    struct JointEntityPaths {
+        std::string position;
+        std::string velocity;
+        std::string effort;
+    };
+
+    struct Link {
+        const UrdfKinematics::Joint* joint;
+        size_t position_index;
+    };
+
+    void _update_joints(const std::vector<std::string>& names);
+
+    const std::string _entity_path;
+    const UrdfKinematics* const _kinematics;
+
+    std::vector<std::string> _names; // the names the caches below were built for
+    std::vector<JointEntityPaths> _joint_entity_paths;
+    std::vector<Link> _links;
+    geometry_msgs::TransformStamped _transform; // reused to avoid allocating the frame ids
+};
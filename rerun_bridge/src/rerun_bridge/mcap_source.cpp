@@ -0,0 +1,277 @@
+#include "mcap_source.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+#define MCAP_IMPLEMENTATION
+#include <mcap/reader.hpp>
+#include <ros/ros.h>
+
+namespace {
+    struct Channel {
+        std::string topic;
+        std::string datatype;
+    };
+
+    using Channels = std::unordered_map<mcap::ChannelId, Channel>;
+
+    void check(const mcap::Status& status, const std::string& what) {
+        if (!status.ok()) {
+            throw std::runtime_error(what + ": " + status.message);
+        }
+    }
+
+    Channels ros1_channels(mcap::McapReader& reader, const OfflineFilter& filter) {
+        Channels channels;
+        for (const auto& [id, channel] : reader.channels()) {
+            if (!filter.has_topic(channel->topic)) {
+                continue;
+            }
+            if (channel->messageEncoding != "ros1") {
+                ROS_WARN(
+                    "Skipping topic %s with %s encoding",
+                    channel->topic.c_str(),
+                    channel->messageEncoding.c_str()
+                );
+                continue;
+            }
+            const auto schema = reader.schema(channel->schemaId);
+            if (!schema) {
+                ROS_WARN("Skipping topic %s without schema", channel->topic.c_str());
+                continue;
+            }
+            channels.emplace(id, Channel{channel->topic, schema->name});
+        }
+        return channels;
+    }
+
+    void decompress(const mcap::Chunk& chunk, std::vector<std::byte>& records) {
+        if (chunk.compression.empty()) {
+            records.assign(chunk.records, chunk.records + chunk.compressedSize);
+#ifndef MCAP_COMPRESSION_NO_LZ4
+        } else if (chunk.compression == "lz4") {
+            check(
+                mcap::LZ4Reader::DecompressAll(
+                    chunk.records, chunk.compressedSize, chunk.uncompressedSize, &records
+                ),
+                "Could not decompress chunk"
+            );
+#endif
+#ifndef MCAP_COMPRESSION_NO_ZSTD
+        } else if (chunk.compression == "zstd") {
+            check(
+                mcap::ZStdReader::DecompressAll(
+                    chunk.records, chunk.compressedSize, chunk.uncompressedSize, &records
+                ),
+                "Could not decompress chunk"
+            );
+#endif
+        } else {
+            throw std::runtime_error("Unsupported chunk compression " + chunk.compression);
+        }
+    }
+
+    struct McapFile {
+        std::string path;
+        Channels channels;
+        std::vector<mcap::ChunkIndex> indexes; // overlapping the window, by chunk start time
+        // log time window, inclusive
+        mcap::Timestamp start = 0;
+        mcap::Timestamp end = std::numeric_limits<mcap::Timestamp>::max();
+
+        bool in_window(mcap::Timestamp log_time) const {
+            return log_time >= start && log_time <= end;
+        }
+    };
+
+    ros::Time from_nsec(uint64_t nsec) {
+        ros::Time time;
+        time.fromNSec(nsec);
+        return time;
+    }
+
+    /// Reads chunks with its own file handle, i.e., one per thread.
+    class ChunkReader {
+      public:
+        explicit ChunkReader(std::shared_ptr<const McapFile> file)
+            : _file(std::move(file)), _handle(std::fopen(_file->path.c_str(), "rb")) {
+            if (_handle == nullptr) {
+                throw std::runtime_error("Could not open " + _file->path);
+            }
+            _reader = std::make_unique<mcap::FileReader>(_handle);
+        }
+
+        ~ChunkReader() {
+            _reader.reset();
+            std::fclose(_handle);
+        }
+
+        ChunkReader(const ChunkReader&) = delete;
+        ChunkReader& operator=(const ChunkReader&) = delete;
+
+        /// Read chunk `i`, decompress it and visit its messages.
+        void read(size_t i, const OfflineVisitor& visit) {
+            mcap::Record record;
+            check(
+                mcap::McapReader::ReadRecord(*_reader, _file->indexes[i].chunkStartOffset, &record),
+                "Could not read chunk"
+            );
+            mcap::Chunk chunk;
+            check(mcap::McapReader::ParseChunk(record, &chunk), "Could not parse chunk");
+            // the chunk points into the buffer of the file reader, which the next read reuses
+            decompress(chunk, _records);
+
+            mcap::BufferReader buffer;
+            buffer.reset(_records.data(), _records.size(), _records.size());
+            mcap::RecordReader records(buffer, 0, _records.size());
+            for (auto message_record = records.next(); message_record;
+                 message_record = records.next()) {
+                if (message_record->opcode != mcap::OpCode::Message) {
+                    continue;
+                }
+                mcap::Message message;
+                check(
+                    mcap::McapReader::ParseMessage(*message_record, &message),
+                    "Could not parse message"
+                );
+                auto channel = _file->channels.find(message.channelId);
+                if (channel != _file->channels.end() && _file->in_window(message.logTime)) {
+                    visit(
+                        channel->second.topic,
+                        channel->second.datatype,
+                        from_nsec(message.logTime),
+                        reinterpret_cast<const uint8_t*>(message.data),
+                        message.dataSize
+                    );
+                }
+            }
+            check(records.status(), "Could not read chunk records");
+        }
+
+      private:
+        const std::shared_ptr<const McapFile> _file;
+        std::FILE* const _handle;
+        std::unique_ptr<mcap::FileReader> _reader;
+        std::vector<std::byte> _records; // uncompressed records of the last chunk, reused
+    };
+
+    /// Read a file without chunks front to back.
+    void read_unchunked(const McapFile& file, const OfflineVisitor& visit) {
+        mcap::McapReader reader;
+        check(reader.open(file.path), "Could not open " + file.path);
+        auto on_problem = [](const mcap::Status& status) {
+            ROS_WARN("%s", status.message.c_str());
+        };
+        // there's no index to seek with, but the reader skips messages before `start` early
+        for (const auto& view : reader.readMessages(on_problem, file.start)) {
+            auto channel = file.channels.find(view.message.channelId);
+            if (channel != file.channels.end() && file.in_window(view.message.logTime)) {
+                visit(
+                    channel->second.topic,
+                    channel->second.datatype,
+                    from_nsec(view.message.logTime),
+                    reinterpret_cast<const uint8_t*>(view.message.data),
+                    view.message.dataSize
+                );
+            }
+        }
+    }
+
+    /// Log time of the first message, from the statistics if the file has them.
+    std::optional<mcap::Timestamp> first_log_time(mcap::McapReader& reader) {
+        if (reader.statistics()) {
+            return reader.statistics()->messageStartTime;
+        }
+        std::optional<mcap::Timestamp> first;
+        for (const auto& index : reader.chunkIndexes()) {
+            first = std::min(first.value_or(index.messageStartTime), index.messageStartTime);
+        }
+        if (!first) {
+            for (const auto& view : reader.readMessages([](const mcap::Status&) {})) {
+                return view.message.logTime;
+            }
+        }
+        return first;
+    }
+
+    /// Whether the chunk contains any of the channels, according to its message index.
+    bool has_any_channel(const mcap::ChunkIndex& index, const Channels& channels) {
+        if (index.messageIndexOffsets.empty()) {
+            // written without message index, the chunk has to be read to know
+            return true;
+        }
+        for (const auto& [channel_id, offset] : index.messageIndexOffsets) {
+            if (channels.find(channel_id) != channels.end()) {
+                return true;
+            }
+        }
+        return false;
+    }
+} // namespace
+
+OfflineSource open_mcap(const std::string& path, const OfflineFilter& filter) {
+    mcap::McapReader reader;
+    check(reader.open(path), "Could not open " + path);
+    check(
+        reader.readSummary(mcap::ReadSummaryMethod::AllowFallbackScan),
+        "Could not read summary of " + path
+    );
+    auto file = std::make_shared<McapFile>();
+    file->path = path;
+    file->channels = ros1_channels(reader, filter);
+    OfflineSource source;
+    const auto first = first_log_time(reader);
+    if (!first || file->channels.empty()) {
+        ROS_WARN("%s has no messages to convert", path.c_str());
+        return source;
+    }
+    file->start = *first + static_cast<mcap::Timestamp>(filter.start * 1e9);
+    if (!std::isinf(filter.end)) {
+        file->end = *first + static_cast<mcap::Timestamp>(filter.end * 1e9);
+    }
+
+    // only chunks overlapping the window and containing selected channels are read at all
+    for (const auto& index : reader.chunkIndexes()) {
+        if (index.messageEndTime >= file->start && index.messageStartTime <= file->end &&
+            has_any_channel(index, file->channels)) {
+            file->indexes.push_back(index);
+        }
+    }
+    std::stable_sort(
+        file->indexes.begin(),
+        file->indexes.end(),
+        [](const mcap::ChunkIndex& a, const mcap::ChunkIndex& b) {
+            return a.messageStartTime < b.messageStartTime;
+        }
+    );
+
+    if (reader.chunkIndexes().empty()) {
+        ROS_INFO("%s has no chunks, reading it sequentially", path.c_str());
+        source.part_starts.push_back(from_nsec(file->start));
+        source.open_reader = [file]() -> OfflinePartReader {
+            return [file](size_t, const OfflineVisitor& visit) { read_unchunked(*file, visit); };
+        };
+        return source;
+    }
+    ROS_INFO(
+        "Reading %zu of %zu chunks of %s",
+        file->indexes.size(),
+        reader.chunkIndexes().size(),
+        path.c_str()
+    );
+    for (const auto& index : file->indexes) {
+        source.part_starts.push_back(from_nsec(std::max(index.messageStartTime, file->start)));
+    }
+    source.open_reader = [file]() -> OfflinePartReader {
+        auto reader = std::make_shared<ChunkReader>(file);
+        return [reader](size_t part, const OfflineVisitor& visit) { reader->read(part, visit); };
+    };
+    return source;
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <string>
+
+#include "offline_source.hpp"
+
+/// Open an MCAP file for `convert_offline`, reading the summary section but no messages yet.
+///
+/// Each chunk is one part, located through the chunk index, so readers on different threads
+/// decompress and parse chunks independently with their own file handles. Only channels with
+/// "ros1" encoding are visited, at their log time. The filter is applied with the summary, i.e.,
+/// only chunks overlapping its time window and containing selected channels (according to their
+/// message index) are read. A file without chunks is a single part read front to back. Throws
+/// std::runtime_error if the file can't be read.
+OfflineSource open_mcap(const std::string& path, const OfflineFilter& filter = OfflineFilter());
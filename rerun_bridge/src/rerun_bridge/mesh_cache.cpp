@@ -0,0 +1,269 @@
+#include "mesh_cache.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+#include <assimp/config.h>
+#include <assimp/Importer.hpp>
+#include <assimp/postprocess.h>
+#include <assimp/scene.h>
+#include <ros/ros.h>
+#include <unistd.h>
+
+namespace {
+    // Cache files are this header followed by the positions, normals, colors (if any) and
+    // triangles as stored in TriangleMesh.
+    struct CacheHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t num_vertices;
+        uint32_t num_triangles;
+        uint32_t has_colors;
+    };
+
+    constexpr char CACHE_MAGIC[8] = "RRBMESH";
+    // bump when changing the format or the import settings
+    constexpr uint32_t CACHE_VERSION = 1;
+
+    bool import_mesh(const std::string& path, TriangleMesh& mesh) {
+        Assimp::Importer importer;
+        // ROS meshes are Z-up like the URDF, don't let assimp rotate Collada files to Y-up
+        importer.SetPropertyBool(AI_CONFIG_IMPORT_COLLADA_IGNORE_UP_DIRECTION, true);
+        importer.SetPropertyInteger(
+            AI_CONFIG_PP_SBP_REMOVE,
+            aiPrimitiveType_POINT | aiPrimitiveType_LINE
+        );
+        const aiScene* scene = importer.ReadFile(
+            path.c_str(),
+            aiProcess_Triangulate | aiProcess_JoinIdenticalVertices | aiProcess_GenNormals |
+                aiProcess_PreTransformVertices | aiProcess_SortByPType
+        );
+        if (scene == nullptr) {
+            ROS_WARN("Could not import mesh %s: %s", path.c_str(), importer.GetErrorString());
+            return false;
+        }
+
+        // all meshes of the scene are merged into one, materials become vertex colors
+        bool has_colors = false;
+        for (unsigned m = 0; m < scene->mNumMeshes; ++m) {
+            const aiMesh* ai_mesh = scene->mMeshes[m];
+            const auto offset = static_cast<uint32_t>(mesh.positions.size());
+
+            aiColor4D material_color{1.0f, 1.0f, 1.0f, 1.0f};
+            if (ai_mesh->mMaterialIndex < scene->mNumMaterials &&
+                aiGetMaterialColor(
+                    scene->mMaterials[ai_mesh->mMaterialIndex],
+                    AI_MATKEY_COLOR_DIFFUSE,
+                    &material_color
+                ) == aiReturn_SUCCESS) {
+                has_colors = true;
+            }
+            const bool vertex_colors = ai_mesh->HasVertexColors(0);
+            has_colors |= vertex_colors;
+
+            for (unsigned v = 0; v < ai_mesh->mNumVertices; ++v) {
+                const auto& position = ai_mesh->mVertices[v];
+                mesh.positions.push_back({position.x, position.y, position.z});
+                if (ai_mesh->HasNormals()) {
+                    const auto& normal = ai_mesh->mNormals[v];
+                    mesh.normals.push_back({normal.x, normal.y, normal.z});
+                } else {
+                    mesh.normals.push_back({0.0f, 0.0f, 1.0f});
+                }
+                const aiColor4D& color = vertex_colors ? ai_mesh->mColors[0][v] : material_color;
+                mesh.colors.push_back(to_rgba32(color.r, color.g, color.b, color.a));
+            }
+            for (unsigned f = 0; f < ai_mesh->mNumFaces; ++f) {
+                const aiFace& face = ai_mesh->mFaces[f];
+                if (face.mNumIndices != 3) {
+                    continue;
+                }
+                const unsigned* indices = face.mIndices;
+                mesh.triangles.push_back(
+                    {offset + indices[0], offset + indices[1], offset + indices[2]}
+                );
+            }
+        }
+        if (!has_colors) {
+            mesh.colors.clear();
+        }
+        return true;
+    }
+} // namespace
+
+uint32_t to_rgba32(float r, float g, float b, float a) {
+    auto channel = [](float value) {
+        return static_cast<uint32_t>(std::min(std::max(value, 0.0f), 1.0f) * 255.0f + 0.5f);
+    };
+    return channel(r) << 24 | channel(g) << 16 | channel(b) << 8 | channel(a);
+}
+
+uint64_t content_hash(const std::string& data) {
+    uint64_t hash = 14695981039346656037ull;
+    for (unsigned char c : data) {
+        hash = (hash ^ c) * 1099511628211ull;
+    }
+    return hash;
+}
+
+bool read_file(const std::string& path, std::string& content) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    std::ostringstream stream;
+    stream << file.rdbuf();
+    content = stream.str();
+    return true;
+}
+
+void TriangleMesh::log_static(
+    const rerun::RecordingStream& rec, const std::string& entity_path,
+    const std::array<float, 3>& scale, const std::optional<uint32_t>& color
+) const {
+    // NOTE normals are left as is, which is exact for the common uniform scales
+    std::vector<std::array<float, 3>> scaled_positions;
+    const auto* vertex_positions = &positions;
+    if (scale != std::array<float, 3>{1.0f, 1.0f, 1.0f}) {
+        scaled_positions.reserve(positions.size());
+        for (const auto& position : positions) {
+            scaled_positions.push_back(
+                {position[0] * scale[0], position[1] * scale[1], position[2] * scale[2]}
+            );
+        }
+        vertex_positions = &scaled_positions;
+    }
+
+    const auto mesh_positions = rerun::Collection<rerun::components::Position3D>::borrow(
+        vertex_positions->data(),
+        vertex_positions->size()
+    );
+    const auto mesh_normals =
+        rerun::Collection<rerun::components::Vector3D>::borrow(normals.data(), normals.size());
+    const auto mesh_triangles = rerun::Collection<rerun::components::TriangleIndices>::borrow(
+        triangles.data(),
+        triangles.size()
+    );
+    auto mesh = rerun::Mesh3D(mesh_positions)
+                    .with_vertex_normals(mesh_normals)
+                    .with_triangle_indices(mesh_triangles);
+    if (color) {
+        mesh = std::move(mesh).with_mesh_material(rerun::Material::from_albedo_factor(*color));
+    } else if (!colors.empty()) {
+        mesh = std::move(mesh).with_vertex_colors(
+            rerun::Collection<rerun::components::Color>::borrow(colors.data(), colors.size())
+        );
+    }
+    rec.log_static(entity_path, mesh);
+}
+
+MeshCache::MeshCache(std::string cache_dir) : _cache_dir(std::move(cache_dir)) {
+    if (!_cache_dir.empty()) {
+        std::error_code error;
+        std::filesystem::create_directories(_cache_dir, error);
+        if (error) {
+            ROS_WARN(
+                "Could not create mesh cache %s: %s",
+                _cache_dir.c_str(),
+                error.message().c_str()
+            );
+        }
+    }
+}
+
+bool MeshCache::load(const std::string& path, TriangleMesh& mesh) const {
+    std::string cache_path;
+    if (!_cache_dir.empty()) {
+        std::string content;
+        if (!read_file(path, content)) {
+            ROS_WARN("Could not read mesh %s", path.c_str());
+            return false;
+        }
+        char name[32];
+        std::snprintf(
+            name,
+            sizeof(name),
+            "%016llx.mesh",
+            static_cast<unsigned long long>(content_hash(content))
+        );
+        cache_path = _cache_dir + "/" + name;
+        if (_read_cached(cache_path, mesh)) {
+            return true;
+        }
+    }
+
+    if (!import_mesh(path, mesh)) {
+        return false;
+    }
+    if (!cache_path.empty()) {
+        _write_cached(cache_path, mesh);
+    }
+    return true;
+}
+
+bool MeshCache::_read_cached(const std::string& cache_path, TriangleMesh& mesh) const {
+    std::ifstream file(cache_path, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    CacheHeader header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        std::memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 ||
+        header.version != CACHE_VERSION) {
+        return false;
+    }
+
+    mesh.positions.resize(header.num_vertices);
+    mesh.normals.resize(header.num_vertices);
+    mesh.colors.resize(header.has_colors ? header.num_vertices : 0);
+    mesh.triangles.resize(header.num_triangles);
+    auto read = [&](auto& values) {
+        return static_cast<bool>(file.read(
+            reinterpret_cast<char*>(values.data()),
+            values.size() * sizeof(values[0])
+        ));
+    };
+    if (!read(mesh.positions) || !read(mesh.normals) || !read(mesh.colors) ||
+        !read(mesh.triangles)) {
+        ROS_WARN("Ignoring truncated mesh cache file %s", cache_path.c_str());
+        mesh = TriangleMesh();
+        return false;
+    }
+    return true;
+}
+
+void MeshCache::_write_cached(const std::string& cache_path, const TriangleMesh& mesh) const {
+    CacheHeader header;
+    std::memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    header.version = CACHE_VERSION;
+    header.num_vertices = static_cast<uint32_t>(mesh.positions.size());
+    header.num_triangles = static_cast<uint32_t>(mesh.triangles.size());
+    header.has_colors = mesh.colors.empty() ? 0 : 1;
+
+    // written to a temporary file first, so concurrent bridges never read a partial file
+    const std::string temporary_path = cache_path + ".tmp" + std::to_string(getpid());
+    {
+        std::ofstream file(temporary_path, std::ios::binary);
+        auto write = [&](const auto& values) {
+            file.write(
+                reinterpret_cast<const char*>(values.data()),
+                values.size() * sizeof(values[0])
+            );
+        };
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        write(mesh.positions);
+        write(mesh.normals);
+        write(mesh.colors);
+        write(mesh.triangles);
+        if (!file) {
+            ROS_WARN("Could not write mesh cache file %s", temporary_path.c_str());
+            std::remove(temporary_path.c_str());
+            return;
+        }
+    }
+    std::rename(temporary_path.c_str(), cache_path.c_str());
+}
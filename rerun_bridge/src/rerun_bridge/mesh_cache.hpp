@@ -0,0 +1,53 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <rerun.hpp>
+
+/// A triangle mesh in the layout of Rerun's Mesh3D components, so it can be logged borrowed.
+struct TriangleMesh {
+    std::vector<std::array<float, 3>> positions;
+    std::vector<std::array<float, 3>> normals;
+    std::vector<uint32_t> colors; // 0xRRGGBBAA per vertex, empty if the mesh has no materials
+    std::vector<std::array<uint32_t, 3>> triangles;
+
+    /// Log as static Mesh3D, scaling the vertices by `scale`. If set, `color` (0xRRGGBBAA)
+    /// replaces the vertex colors.
+    void log_static(
+        const rerun::RecordingStream& rec, const std::string& entity_path,
+        const std::array<float, 3>& scale, const std::optional<uint32_t>& color
+    ) const;
+};
+
+/// Loads meshes through assimp and caches the result in `cache_dir`.
+///
+/// Importing meshes (in particular Collada files) takes far longer than reading back the
+/// triangles, so the converted mesh is stored in a binary file named after the hash of the mesh
+/// file's content. Changed meshes get a new hash and are imported again, stale cache files are
+/// never removed. An empty `cache_dir` disables caching.
+class MeshCache {
+  public:
+    explicit MeshCache(std::string cache_dir);
+
+    /// Returns false if the file can't be read or imported.
+    bool load(const std::string& path, TriangleMesh& mesh) const;
+
+  private:
+    bool _read_cached(const std::string& cache_path, TriangleMesh& mesh) const;
+    void _write_cached(const std::string& cache_path, const TriangleMesh& mesh) const;
+
+    const std::string _cache_dir;
+};
+
+/// Pack a color with channels in [0, 1] as 0xRRGGBBAA.
+uint32_t to_rgba32(float r, float g, float b, float a);
+
+/// 64-bit FNV-1a of `data`, used as cache key.
+uint64_t content_hash(const std::string& data);
+
+/// Read a whole file, returns false if it can't be opened.
+bool read_file(const std::string& path, std::string& content);
@@ -0,0 +1,227 @@
+#include "metrics.hpp"
+
+#include <algorithm>
+#include <mutex>
+#include <sstream>
+
+#include <ros/ros.h>
+
+namespace {
+    const char* tf_failure_name(TfFailure reason) {
+        switch (reason) {
+            case TfFailure::Lookup:
+                return "lookup";
+            case TfFailure::Connectivity:
+                return "connectivity";
+            case TfFailure::Extrapolation:
+                return "extrapolation";
+            case TfFailure::InvalidArgument:
+                return "invalid_argument";
+            case TfFailure::Timeout:
+                return "timeout";
+            case TfFailure::Other:
+            default:
+                return "other";
+        }
+    }
+
+    diagnostic_msgs::KeyValue key_value(const std::string& key, double value) {
+        diagnostic_msgs::KeyValue key_value;
+        key_value.key = key;
+        key_value.value = std::to_string(value);
+        return key_value;
+    }
+
+    void write_histogram(
+        std::ostringstream& out, const std::string& name, const std::string& labels,
+        const Histogram& histogram
+    ) {
+        const auto buckets = histogram.buckets();
+        uint64_t cumulative = 0;
+        for (size_t i = 0; i < Histogram::BOUNDS.size(); ++i) {
+            cumulative += buckets[i];
+            out << name << "_bucket{" << labels << ",le=\"" << Histogram::BOUNDS[i] << "\"} "
+                << cumulative << "\n";
+        }
+        cumulative += buckets.back();
+        out << name << "_bucket{" << labels << ",le=\"+Inf\"} " << cumulative << "\n";
+        out << name << "_sum{" << labels << "} " << histogram.sum() << "\n";
+        out << name << "_count{" << labels << "} " << histogram.count() << "\n";
+    }
+} // namespace
+
+void Histogram::observe(double seconds) {
+    size_t bucket = 0;
+    while (bucket < BOUNDS.size() && seconds > BOUNDS[bucket]) {
+        ++bucket;
+    }
+    _buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    _count.fetch_add(1, std::memory_order_relaxed);
+    const auto nanoseconds = static_cast<uint64_t>(std::max(seconds, 0.0) * 1e9);
+    _sum_ns.fetch_add(nanoseconds, std::memory_order_relaxed);
+}
+
+double Histogram::mean() const {
+    const auto n = count();
+    return n == 0 ? 0.0 : sum() / static_cast<double>(n);
+}
+
+std::array<uint64_t, Histogram::BOUNDS.size() + 1> Histogram::buckets() const {
+    std::array<uint64_t, BOUNDS.size() + 1> buckets;
+    for (size_t i = 0; i < buckets.size(); ++i) {
+        buckets[i] = _buckets[i].load(std::memory_order_relaxed);
+    }
+    return buckets;
+}
+
+TopicMetrics& Metrics::topic(const std::string& topic) {
+    {
+        std::shared_lock<std::shared_mutex> lock(_mutex);
+        auto it = _topics.find(topic);
+        if (it != _topics.end()) {
+            return *it->second;
+        }
+    }
+    std::unique_lock<std::shared_mutex> lock(_mutex);
+    auto& metrics = _topics[topic];
+    if (!metrics) {
+        metrics = std::make_unique<TopicMetrics>(topic);
+    }
+    return *metrics;
+}
+
+uint64_t Metrics::tf_failures() const {
+    uint64_t total = 0;
+    for (const auto& failures : _tf_failures) {
+        total += failures.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+std::string Metrics::to_prometheus() const {
+    struct Counter {
+        const char* name;
+        const char* help;
+        const std::atomic<uint64_t> TopicMetrics::*value;
+        const char* type;
+    };
+    const Counter counters[] = {
+        {"rerun_bridge_messages_received_total",
+         "Messages received.",
+         &TopicMetrics::received,
+         "counter"},
+        {"rerun_bridge_messages_logged_total",
+         "Messages logged.",
+         &TopicMetrics::logged,
+         "counter"},
+        {"rerun_bridge_messages_dropped_total",
+         "Messages dropped before or inside the bridge.",
+         &TopicMetrics::dropped,
+         "counter"},
+        {"rerun_bridge_bytes_logged_total",
+         "Payload bytes logged.",
+         &TopicMetrics::bytes_logged,
+         "counter"},
+        {"rerun_bridge_queue_depth",
+         "Messages buffered inside the bridge.",
+         &TopicMetrics::queue_depth,
+         "gauge"},
+    };
+    struct HistogramInfo {
+        const char* name;
+        const char* help;
+        const Histogram TopicMetrics::*value;
+    };
+    const HistogramInfo histograms[] = {
+        {"rerun_bridge_queue_delay_seconds",
+         "Time from receiving a message to its callback.",
+         &TopicMetrics::queue_delay},
+        {"rerun_bridge_conversion_seconds",
+         "Time spent converting messages.",
+         &TopicMetrics::conversion_time},
+        {"rerun_bridge_log_seconds", "Time spent logging messages.", &TopicMetrics::log_time},
+        {"rerun_bridge_latency_seconds",
+         "Time from header stamp until logged.",
+         &TopicMetrics::latency},
+    };
+
+    std::ostringstream out;
+    std::shared_lock<std::shared_mutex> lock(_mutex);
+    for (const auto& counter : counters) {
+        out << "# HELP " << counter.name << " " << counter.help << "\n";
+        out << "# TYPE " << counter.name << " " << counter.type << "\n";
+        for (const auto& [topic, metrics] : _topics) {
+            out << counter.name << "{topic=\"" << topic << "\"} "
+                << ((*metrics).*counter.value).load(std::memory_order_relaxed) << "\n";
+        }
+    }
+    for (const auto& histogram : histograms) {
+        out << "# HELP " << histogram.name << " " << histogram.help << "\n";
+        out << "# TYPE " << histogram.name << " histogram\n";
+        for (const auto& [topic, metrics] : _topics) {
+            const std::string labels = "topic=\"" + topic + "\"";
+            write_histogram(out, histogram.name, labels, (*metrics).*histogram.value);
+        }
+    }
+
+    out << "# HELP rerun_bridge_tf_failures_total Failed transform lookups.\n";
+    out << "# TYPE rerun_bridge_tf_failures_total counter\n";
+    for (size_t i = 0; i < _tf_failures.size(); ++i) {
+        out << "rerun_bridge_tf_failures_total{reason=\""
+            << tf_failure_name(static_cast<TfFailure>(i)) << "\"} "
+            << _tf_failures[i].load(std::memory_order_relaxed) << "\n";
+    }
+    return out.str();
+}
+
+diagnostic_msgs::DiagnosticArray Metrics::to_diagnostics() {
+    diagnostic_msgs::DiagnosticArray array;
+    array.header.stamp = ros::Time::now();
+
+    std::unique_lock<std::shared_mutex> lock(_mutex);
+    for (const auto& [topic, metrics] : _topics) {
+        diagnostic_msgs::DiagnosticStatus status;
+        status.name = "rerun_bridge: " + topic;
+        status.hardware_id = "rerun_bridge";
+
+        const auto dropped = metrics->dropped.load(std::memory_order_relaxed);
+        auto& dropped_at_last_diagnostics = _dropped_at_last_diagnostics[topic];
+        if (dropped > dropped_at_last_diagnostics) {
+            status.level = diagnostic_msgs::DiagnosticStatus::WARN;
+            status.message = "Dropping messages";
+        } else {
+            status.level = diagnostic_msgs::DiagnosticStatus::OK;
+            status.message = "OK";
+        }
+        dropped_at_last_diagnostics = dropped;
+
+        status.values.push_back(key_value("received", metrics->received.load()));
+        status.values.push_back(key_value("logged", metrics->logged.load()));
+        status.values.push_back(key_value("dropped", dropped));
+        status.values.push_back(key_value("bytes_logged", metrics->bytes_logged.load()));
+        status.values.push_back(key_value("queue_depth", metrics->queue_depth.load()));
+        status.values.push_back(
+            key_value("mean_queue_delay_ms", 1e3 * metrics->queue_delay.mean())
+        );
+        status.values.push_back(
+            key_value("mean_conversion_time_ms", 1e3 * metrics->conversion_time.mean())
+        );
+        status.values.push_back(key_value("mean_log_time_ms", 1e3 * metrics->log_time.mean()));
+        status.values.push_back(key_value("mean_latency_ms", 1e3 * metrics->latency.mean()));
+        array.status.push_back(std::move(status));
+    }
+
+    diagnostic_msgs::DiagnosticStatus tf_status;
+    tf_status.name = "rerun_bridge: tf";
+    tf_status.hardware_id = "rerun_bridge";
+    tf_status.level = diagnostic_msgs::DiagnosticStatus::OK;
+    tf_status.message = "OK";
+    for (size_t i = 0; i < _tf_failures.size(); ++i) {
+        tf_status.values.push_back(key_value(
+            std::string("failures_") + tf_failure_name(static_cast<TfFailure>(i)),
+            _tf_failures[i].load(std::memory_order_relaxed)
+        ));
+    }
+    array.status.push_back(std::move(tf_status));
+    return array;
+}
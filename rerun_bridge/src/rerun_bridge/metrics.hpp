@@ -0,0 +1,132 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+
+#include <diagnostic_msgs/DiagnosticArray.h>
+
+/// Latency histogram with fixed buckets, safe to update concurrently.
+class Histogram {
+  public:
+    /// Upper bounds of the buckets in seconds, the last bucket is unbounded.
+    static constexpr std::array<double, 12> BOUNDS =
+        {1e-5, 5e-5, 1e-4, 5e-4, 1e-3, 2e-3, 5e-3, 1e-2, 2e-2, 5e-2, 1e-1, 1.0};
+
+    void observe(double seconds);
+
+    uint64_t count() const {
+        return _count.load(std::memory_order_relaxed);
+    }
+
+    double sum() const {
+        return static_cast<double>(_sum_ns.load(std::memory_order_relaxed)) * 1e-9;
+    }
+
+    double mean() const;
+
+    /// Counts per bucket, not cumulative.
+    std::array<uint64_t, BOUNDS.size() + 1> buckets() const;
+
+  private:
+    std::array<std::atomic<uint64_t>, BOUNDS.size() + 1> _buckets{};
+    std::atomic<uint64_t> _count{0};
+    std::atomic<uint64_t> _sum_ns{0};
+};
+
+/// Records the time from construction to destruction in a histogram.
+class ScopedTimer {
+  public:
+    explicit ScopedTimer(Histogram& histogram)
+        : _histogram(histogram), _start(std::chrono::steady_clock::now()) {}
+
+    ~ScopedTimer() {
+        _histogram.observe(
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - _start).count()
+        );
+    }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+  private:
+    Histogram& _histogram;
+    const std::chrono::steady_clock::time_point _start;
+};
+
+/// Metrics of a single topic. All counters are updated with relaxed atomics.
+struct TopicMetrics {
+    explicit TopicMetrics(std::string topic_) : topic(std::move(topic_)) {}
+
+    const std::string topic;
+
+    std::atomic<uint64_t> received{0};
+    std::atomic<uint64_t> logged{0};
+    /// Messages lost before (header sequence gaps) or inside the bridge (full or expired buffers).
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<uint64_t> bytes_logged{0};
+    /// Messages buffered inside the bridge, e.g., images waiting for their transform.
+    std::atomic<uint64_t> queue_depth{0};
+    /// Header sequence number of the last message, used to detect drops.
+    std::atomic<uint32_t> last_seq{0};
+
+    /// Time between receiving a message and its callback being called.
+    Histogram queue_delay;
+    /// Time spent converting messages (e.g., image encodings) before logging.
+    Histogram conversion_time;
+    /// Time spent in RecordingStream::log.
+    Histogram log_time;
+    /// Time from the message's header stamp until it has been logged, i.e., the end-to-end latency
+    /// of the source and the bridge.
+    Histogram latency;
+};
+
+enum class TfFailure {
+    Lookup,
+    Connectivity,
+    Extrapolation,
+    InvalidArgument,
+    Timeout,
+    Other,
+};
+
+/// Per-topic and TF metrics of the bridge.
+///
+/// References returned by `topic` stay valid for the lifetime of this object, so subscribers
+/// look up their metrics once and update them without any locking.
+class Metrics {
+  public:
+    TopicMetrics& topic(const std::string& topic);
+
+    void count_tf_failure(TfFailure reason) {
+        _tf_failures[static_cast<size_t>(reason)].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    uint64_t tf_failures() const;
+
+    /// Call `visit` for all topics. Must not call `topic` from within `visit`.
+    template <typename TVisit>
+    void for_each_topic(TVisit&& visit) const {
+        std::shared_lock<std::shared_mutex> lock(_mutex);
+        for (const auto& [name, metrics] : _topics) {
+            visit(*metrics);
+        }
+    }
+
+    /// All metrics in the Prometheus text exposition format.
+    std::string to_prometheus() const;
+
+    /// One status per topic plus one for TF.
+    /// Topics that dropped messages since the previous call are reported as warnings.
+    diagnostic_msgs::DiagnosticArray to_diagnostics();
+
+  private:
+    mutable std::shared_mutex _mutex;
+    std::map<std::string, std::unique_ptr<TopicMetrics>> _topics;
+    std::map<std::string, uint64_t> _dropped_at_last_diagnostics;
+    std::array<std::atomic<uint64_t>, static_cast<size_t>(TfFailure::Other) + 1> _tf_failures{};
+};
@@ -0,0 +1,99 @@
+#include "metrics_server.hpp"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cstring>
+#include <stdexcept>
+
+#include <ros/ros.h>
+
+MetricsServer::MetricsServer(int port, std::function<std::string()> render)
+    : _render(std::move(render)) {
+    _socket = socket(AF_INET, SOCK_STREAM, 0);
+    if (_socket < 0) {
+        throw std::runtime_error(
+            "Could not create metrics socket: " + std::string(strerror(errno))
+        );
+    }
+    int reuse = 1;
+    setsockopt(_socket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(static_cast<uint16_t>(port));
+    if (bind(_socket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 ||
+        listen(_socket, 4) < 0) {
+        const std::string error = strerror(errno);
+        close(_socket);
+        throw std::runtime_error(
+            "Could not serve metrics on port " + std::to_string(port) + ": " + error
+        );
+    }
+    ROS_INFO("Serving metrics on http://localhost:%d/metrics", port);
+
+    _thread = std::thread([this] { _run(); });
+}
+
+MetricsServer::~MetricsServer() {
+    _stop = true;
+    _thread.join();
+    close(_socket);
+}
+
+void MetricsServer::_run() {
+    pollfd listener{_socket, POLLIN, 0};
+    while (!_stop) {
+        // wake up regularly to check for `_stop`
+        if (poll(&listener, 1, 100) <= 0) {
+            continue;
+        }
+        const int client = accept(_socket, nullptr, nullptr);
+        if (client < 0) {
+            continue;
+        }
+        _serve(client);
+        close(client);
+    }
+}
+
+void MetricsServer::_serve(int client) {
+    // only the request line matters, don't wait forever for a client that never sends it
+    pollfd readable{client, POLLIN, 0};
+    if (poll(&readable, 1, 1000) <= 0) {
+        return;
+    }
+    char request[1024];
+    const ssize_t size = recv(client, request, sizeof(request) - 1, 0);
+    if (size <= 0) {
+        return;
+    }
+    request[size] = '\0';
+
+    std::string response;
+    if (std::strncmp(request, "GET /metrics ", 13) == 0) {
+        const std::string body = _render();
+        response = "HTTP/1.1 200 OK\r\n"
+                   "Content-Type: text/plain; version=0.0.4\r\n"
+                   "Content-Length: " +
+                   std::to_string(body.size()) +
+                   "\r\n"
+                   "Connection: close\r\n\r\n" +
+                   body;
+    } else {
+        response = "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+    }
+
+    size_t sent = 0;
+    while (sent < response.size()) {
+        const ssize_t n =
+            send(client, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) {
+            return;
+        }
+        sent += static_cast<size_t>(n);
+    }
+}
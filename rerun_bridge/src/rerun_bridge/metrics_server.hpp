@@ -0,0 +1,29 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <string>
+#include <thread>
+
+/// Minimal HTTP server answering `GET /metrics` on localhost, for scraping by Prometheus.
+///
+/// Requests are served one at a time on a single thread, which is plenty for a scraper polling
+/// every few seconds and keeps the server out of the way of the logging threads.
+class MetricsServer {
+  public:
+    /// `render` is called for every request and returns the response body.
+    MetricsServer(int port, std::function<std::string()> render);
+    ~MetricsServer();
+
+    MetricsServer(const MetricsServer&) = delete;
+    MetricsServer& operator=(const MetricsServer&) = delete;
+
+  private:
+    void _run();
+    void _serve(int client);
+
+    const std::function<std::string()> _render;
+    int _socket = -1;
+    std::atomic<bool> _stop{false};
+    std::thread _thread;
+};
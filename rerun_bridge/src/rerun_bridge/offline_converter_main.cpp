@@ -0,0 +1,101 @@
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <set>
+#include <string>
+#include <thread>
+
+#include <ros/ros.h>
+#include <yaml-cpp/yaml.h>
+#include <rerun.hpp>
+
+#include "mcap_source.hpp"
+#include "offline_logger.hpp"
+#include "offline_pipeline.hpp"
+#include "rosbag_source.hpp"
+
+namespace {
+    void print_usage(const char* program) {
+        std::cerr << "Usage: " << program
+                  << " <input.{bag,mcap}> <output.rrd> [--config <params.yaml>] [--threads <n>]"
+                     " [--start <seconds>] [--end <seconds>] [--topics <topic>[,<topic>...]]\n"
+                     "--start and --end are seconds since the first message of the input.\n";
+    }
+
+    std::set<std::string> split_topics(const std::string& topics) {
+        std::set<std::string> split;
+        size_t begin = 0;
+        while (begin <= topics.size()) {
+            size_t end = topics.find(',', begin);
+            if (end == std::string::npos) {
+                end = topics.size();
+            }
+            if (end > begin) {
+                split.insert(topics.substr(begin, end - begin));
+            }
+            begin = end + 1;
+        }
+        return split;
+    }
+
+    bool ends_with(const std::string& string, const std::string& suffix) {
+        return string.size() >= suffix.size() &&
+               string.compare(string.size() - suffix.size(), suffix.size(), suffix) == 0;
+    }
+} // namespace
+
+/// Converts the ROS1 messages of a bag or MCAP recording to an .rrd file, with the same entity
+/// paths as the bridge node given the same yaml config.
+int main(int argc, char** argv) {
+    std::string input_path;
+    std::string output_path;
+    std::string config_path;
+    size_t num_threads = std::max(std::thread::hardware_concurrency(), 1u);
+    OfflineFilter filter;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--config" && i + 1 < argc) {
+            config_path = argv[++i];
+        } else if (arg == "--threads" && i + 1 < argc) {
+            num_threads = std::strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "--start" && i + 1 < argc) {
+            filter.start = std::strtod(argv[++i], nullptr);
+        } else if (arg == "--end" && i + 1 < argc) {
+            filter.end = std::strtod(argv[++i], nullptr);
+        } else if (arg == "--topics" && i + 1 < argc) {
+            filter.topics = split_topics(argv[++i]);
+        } else if (input_path.empty()) {
+            input_path = arg;
+        } else if (output_path.empty()) {
+            output_path = arg;
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+    if (input_path.empty() || output_path.empty() || filter.start < 0.0 ||
+        filter.end < filter.start) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    // no node, but the log_* functions and throttled logging use ros::Time
+    ros::Time::init();
+
+    const YAML::Node config = config_path.empty() ? YAML::Node() : YAML::LoadFile(config_path);
+    const rerun::RecordingStream rec("rerun_logger_node");
+    rec.save(output_path).exit_on_failure();
+
+    OfflineLogger logger(rec, config);
+    size_t num_messages = 0;
+    try {
+        const OfflineSource source =
+            ends_with(input_path, ".bag") ? open_bag(input_path, filter)
+                                          : open_mcap(input_path, filter);
+        num_messages = convert_offline(source, logger, num_threads);
+    } catch (const std::runtime_error& ex) {
+        ROS_ERROR("%s", ex.what());
+        return 1;
+    }
+    ROS_INFO("Converted %zu messages to %s", num_messages, output_path.c_str());
+    return 0;
+}
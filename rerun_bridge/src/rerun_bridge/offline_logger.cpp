@@ -0,0 +1,171 @@
+#include "offline_logger.hpp"
+
+#include <boost/make_shared.hpp>
+#include <geometry_msgs/PoseStamped.h>
+#include <nav_msgs/Odometry.h>
+#include <ros/serialization.h>
+#include <sensor_msgs/CameraInfo.h>
+#include <sensor_msgs/Image.h>
+#include <sensor_msgs/Imu.h>
+#include <sensor_msgs/JointState.h>
+
+#include "topic_entity_path.hpp"
+
+namespace {
+    template <typename TMessage>
+    boost::shared_ptr<TMessage> deserialize(const uint8_t* data, size_t size) {
+        auto msg = boost::make_shared<TMessage>();
+        ros::serialization::IStream stream(
+            const_cast<uint8_t*>(data), static_cast<uint32_t>(size)
+        );
+        ros::serialization::deserialize(stream, *msg);
+        return msg;
+    }
+} // namespace
+
+OfflineLogger::OfflineLogger(const rerun::RecordingStream& rec, const YAML::Node& config)
+    : _rec(rec) {
+    if (config["topic_to_entity_path"]) {
+        _topic_to_entity_path =
+            config["topic_to_entity_path"].as<std::map<std::string, std::string>>();
+    }
+    if (config["tf"]) {
+        if (config["tf"]["discover"]) {
+            _tf_frames.set_discover(config["tf"]["discover"].as<bool>());
+        }
+        if (config["tf"]["tree"]) {
+            _tf_frames.add_tree(config["tf"]["tree"]);
+        }
+    }
+}
+
+bool OfflineLogger::supports(const std::string& datatype) {
+    return datatype == "sensor_msgs/Image" || datatype == "sensor_msgs/Imu" ||
+           datatype == "geometry_msgs/PoseStamped" || datatype == "tf2_msgs/TFMessage" ||
+           datatype == "nav_msgs/Odometry" || datatype == "sensor_msgs/CameraInfo" ||
+           datatype == "sensor_msgs/JointState";
+}
+
+DecodedMessage OfflineLogger::decode(
+    const std::string& topic, const std::string& datatype, const ros::Time& receive_time,
+    const uint8_t* data, size_t size
+) {
+    DecodedMessage message;
+    message.topic = topic;
+    message.datatype = datatype;
+    message.receive_time = receive_time;
+    if (datatype == "sensor_msgs/Image") {
+        // only the converted image is kept, it's what takes the memory
+        auto msg = deserialize<sensor_msgs::Image>(data, size);
+        message.image = convert_image(msg);
+        message.image_stamp = msg->header.stamp;
+    } else if (datatype == "sensor_msgs/Imu") {
+        message.msg = deserialize<sensor_msgs::Imu>(data, size);
+    } else if (datatype == "geometry_msgs/PoseStamped") {
+        message.msg = deserialize<geometry_msgs::PoseStamped>(data, size);
+    } else if (datatype == "tf2_msgs/TFMessage") {
+        message.msg = deserialize<tf2_msgs::TFMessage>(data, size);
+    } else if (datatype == "nav_msgs/Odometry") {
+        message.msg = deserialize<nav_msgs::Odometry>(data, size);
+    } else if (datatype == "sensor_msgs/CameraInfo") {
+        message.msg = deserialize<sensor_msgs::CameraInfo>(data, size);
+    } else if (datatype == "sensor_msgs/JointState") {
+        message.msg = deserialize<sensor_msgs::JointState>(data, size);
+    }
+    return message;
+}
+
+void OfflineLogger::log(const DecodedMessage& message) {
+    const std::string& topic = message.topic;
+    const std::string& datatype = message.datatype;
+    if (datatype == "sensor_msgs/Image") {
+        log_converted_image(
+            _rec, _entity_path(topic), message.image, _normalize_timestamp(message.image_stamp)
+        );
+    } else if (datatype == "sensor_msgs/Imu") {
+        auto msg = boost::static_pointer_cast<const sensor_msgs::Imu>(message.msg);
+        log_imu(_rec, _entity_path(topic), msg, _normalize_timestamp(msg->header.stamp));
+    } else if (datatype == "geometry_msgs/PoseStamped") {
+        auto msg = boost::static_pointer_cast<const geometry_msgs::PoseStamped>(message.msg);
+        log_pose_stamped(_rec, _entity_path(topic), msg, _normalize_timestamp(msg->header.stamp));
+    } else if (datatype == "tf2_msgs/TFMessage") {
+        auto msg = boost::static_pointer_cast<const tf2_msgs::TFMessage>(message.msg);
+        if (is_tf_static_topic(topic)) {
+            _log_tf_static_message(*msg);
+        } else {
+            _log_tf_message(*msg);
+        }
+    } else if (datatype == "nav_msgs/Odometry") {
+        auto msg = boost::static_pointer_cast<const nav_msgs::Odometry>(message.msg);
+        log_odometry(_rec, _entity_path(topic), msg, _normalize_timestamp(msg->header.stamp));
+    } else if (datatype == "sensor_msgs/CameraInfo") {
+        auto msg = boost::static_pointer_cast<const sensor_msgs::CameraInfo>(message.msg);
+        // NOTE log_camera_info doesn't set the time itself
+        const double normalized_timestamp = _normalize_timestamp(msg->header.stamp);
+        _rec.set_time_seconds("timestamp", normalized_timestamp);
+        log_camera_info(_rec, _entity_path(topic, true), msg, normalized_timestamp);
+    } else if (datatype == "sensor_msgs/JointState") {
+        auto msg = boost::static_pointer_cast<const sensor_msgs::JointState>(message.msg);
+        log_joint_state(_rec, _entity_path(topic), msg, _normalize_timestamp(msg->header.stamp));
+    }
+}
+
+/// Same entity paths as the node, i.e., CameraInfo topics that aren't mapped explicitly are
+/// logged to the parent of their image.
+const std::string& OfflineLogger::_entity_path(const std::string& topic, bool camera_info) {
+    auto resolved = _resolved_entity_paths.find(topic);
+    if (resolved == _resolved_entity_paths.end()) {
+        std::string entity_path = resolve_entity_path(_topic_to_entity_path, topic);
+        if (camera_info && _topic_to_entity_path.find(topic) == _topic_to_entity_path.end()) {
+            entity_path = parent_entity_path(entity_path);
+        }
+        resolved = _resolved_entity_paths.emplace(topic, std::move(entity_path)).first;
+    }
+    return resolved->second;
+}
+
+double OfflineLogger::_normalize_timestamp(const ros::Time& stamp) {
+    if (!_time_offset_initialized) {
+        _time_offset = stamp.toSec();
+        _time_offset_initialized = true;
+        ROS_INFO("Initialized time offset to %.6f", _time_offset);
+    }
+    return stamp.toSec() - _time_offset;
+}
+
+void OfflineLogger::_log_tf_message(const tf2_msgs::TFMessage& msg) {
+    const ros::Time* time_stamp = nullptr; // stamp the timeline was last set to
+    for (const auto& transform : msg.transforms) {
+        const std::string entity_path =
+            _tf_frames.entity_path(transform.child_frame_id, transform.header.frame_id);
+        if (entity_path.empty()) {
+            if (_skipped_frames.insert(transform.child_frame_id).second) {
+                ROS_WARN(
+                    "No entity path for frame_id %s, skipping", transform.child_frame_id.c_str()
+                );
+            }
+            continue;
+        }
+        if (time_stamp == nullptr || transform.header.stamp != *time_stamp) {
+            time_stamp = &transform.header.stamp;
+            _rec.set_time_seconds("timestamp", _normalize_timestamp(transform.header.stamp));
+        }
+        _rec.log(entity_path, to_transform3d(transform.transform));
+    }
+}
+
+void OfflineLogger::_log_tf_static_message(const tf2_msgs::TFMessage& msg) {
+    for (const auto& transform : msg.transforms) {
+        auto logged = _static_transforms.find(transform.child_frame_id);
+        if (logged != _static_transforms.end() && logged->second == transform.transform) {
+            continue;
+        }
+        const std::string entity_path =
+            _tf_frames.entity_path(transform.child_frame_id, transform.header.frame_id);
+        if (entity_path.empty()) {
+            continue;
+        }
+        log_static_transform(_rec, entity_path, transform);
+        _static_transforms[transform.child_frame_id] = transform.transform;
+    }
+}
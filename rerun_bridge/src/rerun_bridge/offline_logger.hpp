@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <set>
+#include <string>
+
+#include <boost/shared_ptr.hpp>
+#include <geometry_msgs/Transform.h>
+#include <ros/ros.h>
+#include <tf2_msgs/TFMessage.h>
+#include <yaml-cpp/yaml.h>
+#include <rerun.hpp>
+
+#include "rerun_bridge/rerun_ros_interface.hpp"
+#include "tf_frame_index.hpp"
+
+/// A message deserialized (and, for images, converted) ahead of logging it, see
+/// `OfflineLogger::decode`.
+struct DecodedMessage {
+    std::string topic;
+    std::string datatype;
+    ros::Time receive_time;
+    boost::shared_ptr<const void> msg; // of `datatype`, null for images
+    ConvertedImage image;
+    ros::Time image_stamp;
+};
+
+/// Logs ROS1-serialized messages read from a recording, instead of received on live topics,
+/// with the same log_* functions and entity paths as the bridge node.
+///
+/// Messages are logged at their header stamps like in the node. There is no TF buffer, so
+/// transforms are logged as recorded (no fixed rate interpolation) and images aren't placed
+/// relative to `tf/root_frame`.
+class OfflineLogger {
+  public:
+    /// Uses `topic_to_entity_path` and `tf` (`tree` and `discover`) of a bridge yaml config.
+    OfflineLogger(const rerun::RecordingStream& rec, const YAML::Node& config);
+
+    /// Whether messages of the given type (e.g., "sensor_msgs/Image") are logged.
+    static bool supports(const std::string& datatype);
+
+    /// Deserialize a message of a supported type and convert images, the expensive part of
+    /// logging. Thread-safe, unlike `log`. Throws if the message can't be decoded.
+    static DecodedMessage decode(
+        const std::string& topic, const std::string& datatype, const ros::Time& receive_time,
+        const uint8_t* data, size_t size
+    );
+
+    void log(const DecodedMessage& message);
+
+  private:
+    const std::string& _entity_path(const std::string& topic, bool camera_info = false);
+    double _normalize_timestamp(const ros::Time& stamp);
+    void _log_tf_message(const tf2_msgs::TFMessage& msg);
+    void _log_tf_static_message(const tf2_msgs::TFMessage& msg);
+
+    const rerun::RecordingStream& _rec;
+    std::map<std::string, std::string> _topic_to_entity_path;
+    std::map<std::string, std::string> _resolved_entity_paths; // by topic
+    TfFrameIndex _tf_frames;
+    std::map<std::string, geometry_msgs::Transform> _static_transforms; // last logged per frame
+    std::set<std::string> _skipped_frames; // warned about once
+
+    bool _time_offset_initialized = false;
+    double _time_offset = 0.0;
+};
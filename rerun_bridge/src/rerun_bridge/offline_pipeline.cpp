@@ -0,0 +1,207 @@
+#include "offline_pipeline.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <queue>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+    struct DecodedPart {
+        std::vector<DecodedMessage> messages; // by receive time
+        std::string error;                    // set instead of throwing across threads
+    };
+
+    DecodedPart decode_part(const OfflinePartReader& reader, size_t part) {
+        DecodedPart decoded;
+        reader(
+            part,
+            [&](const std::string& topic,
+                const std::string& datatype,
+                const ros::Time& receive_time,
+                const uint8_t* data,
+                size_t size) {
+                if (!OfflineLogger::supports(datatype)) {
+                    return;
+                }
+                try {
+                    decoded.messages.push_back(
+                        OfflineLogger::decode(topic, datatype, receive_time, data, size)
+                    );
+                } catch (const std::exception& ex) {
+                    ROS_WARN_THROTTLE(1.0, "Skipping message on %s: %s", topic.c_str(), ex.what());
+                }
+            }
+        );
+        // sources usually visit in receive time order, but don't have to
+        std::stable_sort(
+            decoded.messages.begin(),
+            decoded.messages.end(),
+            [](const DecodedMessage& a, const DecodedMessage& b) {
+                return a.receive_time < b.receive_time;
+            }
+        );
+        return decoded;
+    }
+
+    /// Decodes parts on worker threads, at most `window` parts ahead of the consumer.
+    class PartPipeline {
+      public:
+        PartPipeline(const OfflineSource& source, size_t num_threads)
+            : _source(source), _window(2 * num_threads), _slots(_window), _ready(_window, false) {
+            for (size_t i = 0; i < num_threads; ++i) {
+                _workers.emplace_back([this] { _work(); });
+            }
+        }
+
+        ~PartPipeline() {
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _stop = true;
+            }
+            _condition.notify_all();
+            for (auto& worker : _workers) {
+                worker.join();
+            }
+        }
+
+        /// Block until part `i` is decoded and return it. Parts must be taken in order.
+        DecodedPart take(size_t i) {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _condition.wait(lock, [&] { return _ready[i % _window]; });
+            DecodedPart part = std::move(_slots[i % _window]);
+            _slots[i % _window] = DecodedPart();
+            _ready[i % _window] = false;
+            _taken = i + 1;
+            lock.unlock();
+            _condition.notify_all();
+            return part;
+        }
+
+      private:
+        void _work() {
+            OfflinePartReader reader;
+            std::string open_error;
+            try {
+                reader = _source.open_reader();
+            } catch (const std::exception& ex) {
+                open_error = ex.what();
+            }
+            const size_t num_parts = _source.part_starts.size();
+            while (true) {
+                size_t i;
+                {
+                    std::unique_lock<std::mutex> lock(_mutex);
+                    _condition.wait(lock, [&] {
+                        return _stop || _next == num_parts || _next < _taken + _window;
+                    });
+                    if (_stop || _next == num_parts) {
+                        break;
+                    }
+                    i = _next++;
+                }
+                DecodedPart decoded;
+                try {
+                    if (!reader) {
+                        throw std::runtime_error(open_error);
+                    }
+                    decoded = decode_part(reader, i);
+                } catch (const std::exception& ex) {
+                    decoded.error = ex.what();
+                }
+                {
+                    std::lock_guard<std::mutex> lock(_mutex);
+                    _slots[i % _window] = std::move(decoded);
+                    _ready[i % _window] = true;
+                }
+                _condition.notify_all();
+            }
+        }
+
+        const OfflineSource& _source;
+        const size_t _window;
+
+        std::mutex _mutex;
+        std::condition_variable _condition;
+        std::vector<DecodedPart> _slots; // part i is in slot i % window
+        std::vector<bool> _ready;
+        size_t _next = 0;  // next part to decode
+        size_t _taken = 0; // parts taken by the consumer
+        bool _stop = false;
+        std::vector<std::thread> _workers;
+    };
+
+    /// The next message of a part in the merge.
+    struct Head {
+        ros::Time receive_time;
+        size_t part;
+        size_t index;
+
+        /// Later heads have lower priority, ties go to the earlier part to keep the merge stable.
+        bool operator<(const Head& other) const {
+            if (receive_time != other.receive_time) {
+                return receive_time > other.receive_time;
+            }
+            return part > other.part;
+        }
+    };
+} // namespace
+
+size_t convert_offline(const OfflineSource& source, OfflineLogger& logger, size_t num_threads) {
+    return convert_offline(
+        source, [&](const DecodedMessage& message) { logger.log(message); }, num_threads
+    );
+}
+
+size_t convert_offline(const OfflineSource& source, const OfflineSink& sink, size_t num_threads) {
+    const size_t num_parts = source.part_starts.size();
+    if (num_parts == 0) {
+        return 0;
+    }
+    num_threads = std::max<size_t>(std::min(num_threads, num_parts), 1);
+    ROS_INFO("Decoding %zu parts with %zu threads", num_parts, num_threads);
+
+    PartPipeline pipeline(source, num_threads);
+    std::map<size_t, DecodedPart> parts; // taken and not yet logged completely
+    std::priority_queue<Head> heads;
+    size_t next_part = 0;
+    size_t num_logged = 0;
+    while (true) {
+        // A part can only contain messages before the current head if it starts before it.
+        // Parts start in order, so all others can wait.
+        while (next_part < num_parts &&
+               (heads.empty() || source.part_starts[next_part] <= heads.top().receive_time)) {
+            DecodedPart part = pipeline.take(next_part);
+            if (!part.error.empty()) {
+                throw std::runtime_error(part.error);
+            }
+            if (!part.messages.empty()) {
+                heads.push({part.messages.front().receive_time, next_part, 0});
+                parts.emplace(next_part, std::move(part));
+            }
+            next_part++;
+        }
+        if (heads.empty()) {
+            break;
+        }
+
+        Head head = heads.top();
+        heads.pop();
+        auto& messages = parts.at(head.part).messages;
+        sink(messages[head.index]);
+        // release images as soon as they are logged instead of with their part
+        messages[head.index] = DecodedMessage();
+        num_logged++;
+        if (++head.index < messages.size()) {
+            head.receive_time = messages[head.index].receive_time;
+            heads.push(head);
+        } else {
+            parts.erase(head.part);
+        }
+    }
+    return num_logged;
+}
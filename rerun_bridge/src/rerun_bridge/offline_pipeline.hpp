@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+
+#include "offline_logger.hpp"
+#include "offline_source.hpp"
+
+/// Called with each decoded message in receive time order, see `convert_offline`.
+using OfflineSink = std::function<void(const DecodedMessage& message)>;
+
+/// Log all supported messages of `source` with `logger`, returns the number of messages logged.
+///
+/// `num_threads` workers each read whole parts of the source and decode their messages
+/// (deserialization and image conversion), at most a few parts per worker ahead of the logging.
+/// The calling thread k-way merges the decoded parts by receive time, so messages are logged in
+/// the order they were recorded even if parts overlap, and does the (cheap) logging itself.
+/// Throws std::runtime_error if a part can't be read.
+size_t convert_offline(const OfflineSource& source, OfflineLogger& logger, size_t num_threads);
+
+/// Same as above, but hands the merged messages to `sink` instead of logging them.
+size_t convert_offline(const OfflineSource& source, const OfflineSink& sink, size_t num_threads);
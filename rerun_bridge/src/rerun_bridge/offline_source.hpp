@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <ros/ros.h>
+
+/// Called for each ROS1-serialized message of a recording with its receive time (the log time
+/// of MCAP, the record time of bags). The data is only valid during the call.
+using OfflineVisitor = std::function<void(
+    const std::string& topic, const std::string& datatype, const ros::Time& receive_time,
+    const uint8_t* data, size_t size
+)>;
+
+/// Selects what sources visit, it's applied through their indexes, e.g., a short time window of
+/// a long recording only reads the chunks overlapping it.
+struct OfflineFilter {
+    double start = 0.0; // seconds since the first message
+    double end = std::numeric_limits<double>::infinity();
+    std::set<std::string> topics; // all if empty
+
+    bool has_topic(const std::string& topic) const {
+        return topics.empty() || topics.count(topic) > 0;
+    }
+};
+
+/// Visits the messages of one part of a recording, in any order.
+using OfflinePartReader = std::function<void(size_t part, const OfflineVisitor& visit)>;
+
+/// A recording split into parts that can be read independently, e.g., the chunks of an MCAP
+/// file or time ranges of a bag, see `convert_offline`.
+struct OfflineSource {
+    /// Lower bound of the receive times in each part, ascending. Parts may overlap.
+    std::vector<ros::Time> part_starts;
+
+    /// Create a reader for one thread, e.g., with its own file handle. Readers of different
+    /// threads are used concurrently.
+    std::function<OfflinePartReader()> open_reader;
+};
@@ -0,0 +1,142 @@
+#include "pending_transform_queue.hpp"
+
+namespace {
+    // Returned by addTransformableRequest if the request can never be fulfilled (too old).
+    constexpr tf2::TransformableRequestHandle INVALID_REQUEST = 0xffffffffffffffffULL;
+} // namespace
+
+PendingTransformQueue::PendingTransformQueue(
+    tf2_ros::Buffer& buffer, std::string target_frame, const Options& options,
+    std::function<void()> on_transformable
+)
+    : _buffer(buffer),
+      _target_frame(std::move(target_frame)),
+      _options(options),
+      _notify(std::move(on_transformable)) {
+    _callback_handle = _buffer.addTransformableCallback(
+        [this](
+            tf2::TransformableRequestHandle handle,
+            const std::string&,
+            const std::string&,
+            ros::Time,
+            tf2::TransformableResult result
+        ) { _on_transformable(handle, result); }
+    );
+}
+
+PendingTransformQueue::~PendingTransformQueue() {
+    // also cancels all outstanding requests registered with this callback
+    _buffer.removeTransformableCallback(_callback_handle);
+}
+
+PendingTransformQueue::Status PendingTransformQueue::lookup(
+    const std::string& frame_id, const ros::Time& stamp, geometry_msgs::TransformStamped& transform
+) {
+    auto lookup_now = [&]() {
+        try {
+            transform = _buffer.lookupTransform(_target_frame, frame_id, stamp);
+            return Status::Available;
+        } catch (tf2::TransformException& ex) {
+            ROS_WARN("%s", ex.what());
+            return Status::Failed;
+        }
+    };
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _apply_resolved();
+
+    auto it = _requests.find({frame_id, stamp});
+    if (it == _requests.end()) {
+        if (_buffer.canTransform(_target_frame, frame_id, stamp)) {
+            return lookup_now();
+        }
+        if (_requests.size() >= _options.max_pending) {
+            ROS_WARN_THROTTLE(
+                1.0,
+                "Too many pending transforms to %s, failing lookup for %s",
+                _target_frame.c_str(),
+                frame_id.c_str()
+            );
+            return Status::Failed;
+        }
+
+        auto handle =
+            _buffer.addTransformableRequest(_callback_handle, _target_frame, frame_id, stamp);
+        if (handle == 0) {
+            // became available in the meantime
+            return lookup_now();
+        } else if (handle == INVALID_REQUEST) {
+            return Status::Failed;
+        }
+        _requests[{frame_id, stamp}] = {handle, Status::Pending, Clock::now()};
+        _handle_to_key[handle] = {frame_id, stamp};
+        return Status::Pending;
+    }
+
+    switch (it->second.status) {
+        case Status::Pending: {
+            const auto max_age = std::chrono::duration<double>(_options.max_age);
+            if (Clock::now() - it->second.registered <= max_age) {
+                return Status::Pending;
+            }
+            _buffer.cancelTransformableRequest(it->second.handle);
+            _erase(it);
+            return Status::Failed;
+        }
+        case Status::Available:
+            _erase(it);
+            return lookup_now();
+        case Status::Failed:
+        default:
+            _erase(it);
+            return Status::Failed;
+    }
+}
+
+void PendingTransformQueue::cancel(const std::string& frame_id, const ros::Time& stamp) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _apply_resolved();
+
+    auto it = _requests.find({frame_id, stamp});
+    if (it == _requests.end()) {
+        return;
+    }
+    if (it->second.status == Status::Pending) {
+        _buffer.cancelTransformableRequest(it->second.handle);
+    }
+    _erase(it);
+}
+
+void PendingTransformQueue::_on_transformable(
+    tf2::TransformableRequestHandle handle, tf2::TransformableResult result
+) {
+    {
+        std::lock_guard<std::mutex> lock(_resolved_mutex);
+        _resolved.emplace_back(handle, result);
+    }
+    _notify();
+}
+
+void PendingTransformQueue::_apply_resolved() {
+    std::vector<std::pair<tf2::TransformableRequestHandle, tf2::TransformableResult>> resolved;
+    {
+        std::lock_guard<std::mutex> lock(_resolved_mutex);
+        resolved.swap(_resolved);
+    }
+
+    for (const auto& [handle, result] : resolved) {
+        auto key = _handle_to_key.find(handle);
+        if (key == _handle_to_key.end()) {
+            // already cancelled
+            continue;
+        }
+        auto& request = _requests.at(key->second);
+        request.status =
+            (result == tf2::TransformAvailable) ? Status::Available : Status::Failed;
+    }
+}
+
+void PendingTransformQueue::_erase(std::map<Key, Request>::iterator it) {
+    _handle_to_key.erase(it->second.handle);
+    _requests.erase(it);
+}
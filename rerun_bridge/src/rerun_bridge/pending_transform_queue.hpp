@@ -0,0 +1,82 @@
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <geometry_msgs/TransformStamped.h>
+#include <ros/ros.h>
+#include <tf2/buffer_core.h>
+#include <tf2_ros/buffer.h>
+
+/// Deferred transform lookups into a fixed target frame, keyed by source frame and stamp.
+///
+/// Works like tf2_ros::MessageFilter: a lookup that can't be answered yet registers a
+/// transformable request with the buffer and `on_transformable` is called as soon as tf2 has the
+/// data, so callers never have to block or poll with a timeout. The number of outstanding
+/// requests is bounded and requests older than `max_age` fail.
+class PendingTransformQueue {
+  public:
+    enum class Status { Available, Pending, Failed };
+
+    struct Options {
+        /// Maximum number of outstanding requests, new requests fail when this is reached.
+        size_t max_pending = 100;
+        /// Maximum wall time a request stays pending before it fails.
+        double max_age = 0.5;
+    };
+
+    PendingTransformQueue(
+        tf2_ros::Buffer& buffer, std::string target_frame, const Options& options,
+        std::function<void()> on_transformable
+    );
+    ~PendingTransformQueue();
+
+    PendingTransformQueue(const PendingTransformQueue&) = delete;
+    PendingTransformQueue& operator=(const PendingTransformQueue&) = delete;
+
+    /// Look up the transform from `frame_id` to the target frame at `stamp`.
+    /// Registers a request if the transform is not available yet. Once a request is resolved,
+    /// i.e., Available or Failed is returned, it is removed from the queue.
+    Status lookup(
+        const std::string& frame_id, const ros::Time& stamp,
+        geometry_msgs::TransformStamped& transform
+    );
+
+    /// Drop an outstanding request, e.g., because the message waiting for it was discarded.
+    void cancel(const std::string& frame_id, const ros::Time& stamp);
+
+  private:
+    using Clock = std::chrono::steady_clock;
+    using Key = std::pair<std::string, ros::Time>;
+
+    struct Request {
+        tf2::TransformableRequestHandle handle;
+        Status status;
+        Clock::time_point registered;
+    };
+
+    void _on_transformable(tf2::TransformableRequestHandle handle, tf2::TransformableResult result);
+    void _apply_resolved();
+    void _erase(std::map<Key, Request>::iterator it);
+
+    tf2_ros::Buffer& _buffer;
+    const std::string _target_frame;
+    const Options _options;
+    const std::function<void()> _notify;
+    tf2::TransformableCallbackHandle _callback_handle;
+
+    std::mutex _mutex;
+    std::map<Key, Request> _requests;
+    std::map<tf2::TransformableRequestHandle, Key> _handle_to_key;
+
+    // NOTE tf2 invokes the transformable callback while holding its own lock, which we also
+    //   acquire (through the buffer) while holding `_mutex`. The callback therefore only appends
+    //   to this separately locked list, which is applied the next time `_mutex` is held.
+    std::mutex _resolved_mutex;
+    std::vector<std::pair<tf2::TransformableRequestHandle, tf2::TransformableResult>> _resolved;
+};
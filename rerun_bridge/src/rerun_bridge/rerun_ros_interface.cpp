@@ -20,28 +20,42 @@ void log_image(
     const rerun::RecordingStream& rec, const std::string& entity_path,
     const sensor_msgs::Image::ConstPtr& msg, double normalized_timestamp
 ) {
-    rec.set_time_seconds("timestamp", normalized_timestamp);
+    log_converted_image(rec, entity_path, convert_image(msg), normalized_timestamp);
+}
 
+ConvertedImage convert_image(const sensor_msgs::Image::ConstPtr& msg) {
     // Depth images are 32-bit float (in meters) or 16-bit uint (in millimeters)
     // See: https://ros.org/reps/rep-0118.html
     if (msg->encoding == "16UC1") {
-        cv::Mat img = cv_bridge::toCvCopy(msg)->image;
-        rec.log(
-            entity_path,
-            rerun::DepthImage({img.rows, img.cols}, rerun::TensorBuffer::u16(img)).with_meter(1000)
-        );
+        return {cv_bridge::toCvCopy(msg)->image, 1000.0f};
     } else if (msg->encoding == "32FC1") {
         // NOTE this has not been tested
-        cv::Mat img = cv_bridge::toCvCopy(msg)->image;
+        return {cv_bridge::toCvCopy(msg)->image, 1.0f};
+    } else {
+        return {cv_bridge::toCvCopy(msg, "rgb8")->image, 0.0f};
+    }
+}
+
+void log_converted_image(
+    const rerun::RecordingStream& rec, const std::string& entity_path, const ConvertedImage& image,
+    double normalized_timestamp
+) {
+    rec.set_time_seconds("timestamp", normalized_timestamp);
+
+    const cv::Mat& img = image.image;
+    if (image.meter == 0.0f) {
+        rec.log(entity_path, rerun::Image(tensor_shape(img), rerun::TensorBuffer::u8(img)));
+    } else if (img.depth() == CV_16U) {
         rec.log(
             entity_path,
-            rerun::DepthImage({img.rows, img.cols}, rerun::TensorBuffer::f32(img)).with_meter(1.0)
+            rerun::DepthImage({img.rows, img.cols}, rerun::TensorBuffer::u16(img))
+                .with_meter(image.meter)
         );
     } else {
-        cv::Mat img = cv_bridge::toCvCopy(msg, "rgb8")->image;
         rec.log(
             entity_path,
-            rerun::Image(tensor_shape(img), rerun::TensorBuffer::u8(img))
+            rerun::DepthImage({img.rows, img.cols}, rerun::TensorBuffer::f32(img))
+                .with_meter(image.meter)
         );
     }
 }
@@ -83,31 +97,27 @@ void log_tf_message(
     const std::map<std::string, std::string>& tf_frame_to_entity_path,
     const tf2_msgs::TFMessage::ConstPtr& msg, double normalized_timestamp
 ) {
+    if (msg->transforms.empty()) {
+        return;
+    }
+    const ros::Time& first_stamp = msg->transforms[0].header.stamp;
+    const ros::Time* time_stamp = nullptr; // stamp the timeline was last set to
     for (const auto& transform : msg->transforms) {
-        if (tf_frame_to_entity_path.find(transform.child_frame_id) ==
-            tf_frame_to_entity_path.end()) {
+        auto entity_path = tf_frame_to_entity_path.find(transform.child_frame_id);
+        if (entity_path == tf_frame_to_entity_path.end()) {
             ROS_WARN("No entity path for frame_id %s, skipping", transform.child_frame_id.c_str());
             continue;
         }
 
-        rec.set_time_seconds("timestamp", normalized_timestamp);
+        if (time_stamp == nullptr || transform.header.stamp != *time_stamp) {
+            time_stamp = &transform.header.stamp;
+            rec.set_time_seconds(
+                "timestamp",
+                normalized_timestamp + (transform.header.stamp - first_stamp).toSec()
+            );
+        }
 
-        rec.log(
-            tf_frame_to_entity_path.at(transform.child_frame_id),
-            rerun::Transform3D(
-                rerun::Vector3D(
-                    transform.transform.translation.x,
-                    transform.transform.translation.y,
-                    transform.transform.translation.z
-                ),
-                rerun::Quaternion::from_wxyz(
-                    transform.transform.rotation.w,
-                    transform.transform.rotation.x,
-                    transform.transform.rotation.y,
-                    transform.transform.rotation.z
-                )
-            )
-        );
+        rec.log(entity_path->second, to_transform3d(transform.transform));
     }
 }
 
@@ -135,6 +145,27 @@ void log_odometry(
     );
 }
 
+void log_joint_state(
+    const rerun::RecordingStream& rec, const std::string& entity_path,
+    const sensor_msgs::JointState::ConstPtr& msg, double normalized_timestamp
+) {
+    rec.set_time_seconds("timestamp", normalized_timestamp);
+
+    // the position, velocity and effort arrays are either empty or as long as the names
+    for (size_t i = 0; i < msg->name.size(); ++i) {
+        const std::string joint_entity_path = entity_path + "/" + msg->name[i];
+        if (i < msg->position.size()) {
+            rec.log(joint_entity_path + "/position", rerun::Scalar(msg->position[i]));
+        }
+        if (i < msg->velocity.size()) {
+            rec.log(joint_entity_path + "/velocity", rerun::Scalar(msg->velocity[i]));
+        }
+        if (i < msg->effort.size()) {
+            rec.log(joint_entity_path + "/effort", rerun::Scalar(msg->effort[i]));
+        }
+    }
+}
+
 void log_camera_info(
     const rerun::RecordingStream& rec, const std::string& entity_path,
     const sensor_msgs::CameraInfo::ConstPtr& msg, double normalized_timestamp
@@ -158,26 +189,30 @@ void log_camera_info(
     );
 }
 
+rerun::Transform3D to_transform3d(const geometry_msgs::Transform& transform) {
+    return rerun::Transform3D(
+        rerun::Vector3D(transform.translation.x, transform.translation.y, transform.translation.z),
+        rerun::Quaternion::from_wxyz(
+            transform.rotation.w,
+            transform.rotation.x,
+            transform.rotation.y,
+            transform.rotation.z
+        )
+    );
+}
+
 void log_transform(
     const rerun::RecordingStream& rec, const std::string& entity_path,
     const geometry_msgs::TransformStamped& msg, double normalized_timestamp
 ) {
     rec.set_time_seconds("timestamp", normalized_timestamp);
 
-    rec.log(
-        entity_path,
-        rerun::Transform3D(
-            rerun::Vector3D(
-                msg.transform.translation.x,
-                msg.transform.translation.y,
-                msg.transform.translation.z
-            ),
-            rerun::Quaternion::from_wxyz(
-                msg.transform.rotation.w,
-                msg.transform.rotation.x,
-                msg.transform.rotation.y,
-                msg.transform.rotation.z
-            )
-        )
-    );
+    rec.log(entity_path, to_transform3d(msg.transform));
+}
+
+void log_static_transform(
+    const rerun::RecordingStream& rec, const std::string& entity_path,
+    const geometry_msgs::TransformStamped& msg
+) {
+    rec.log_static(entity_path, to_transform3d(msg.transform));
 }
@@ -0,0 +1,127 @@
+#include "rosbag_source.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <vector>
+
+#include <rosbag/bag.h>
+#include <rosbag/query.h>
+#include <rosbag/view.h>
+#include <ros/serialization.h>
+
+namespace {
+    constexpr uint64_t PART_SIZE = 64ull << 20; // bytes of bag per time range, roughly
+
+    struct BagFile {
+        std::string path;
+        std::vector<std::string> topics; // all if empty
+        std::vector<ros::Time> part_starts;
+        ros::Time end; // of the last part, inclusive
+    };
+
+    /// Add the messages of `topics` (all if empty) between `start` and `end` to `view`. Views only
+    /// read the chunks whose index has such messages.
+    void add_query(
+        rosbag::View& view, const rosbag::Bag& bag, const std::vector<std::string>& topics,
+        const ros::Time& start, const ros::Time& end
+    ) {
+        if (topics.empty()) {
+            view.addQuery(bag, start, end);
+        } else {
+            view.addQuery(bag, rosbag::TopicQuery(topics), start, end);
+        }
+    }
+
+    /// Reads time ranges with its own bag handle, i.e., one per thread.
+    class RangeReader {
+      public:
+        explicit RangeReader(std::shared_ptr<const BagFile> file) : _file(std::move(file)) {
+            _bag.open(_file->path, rosbag::bagmode::Read);
+        }
+
+        void read(size_t i, const OfflineVisitor& visit) {
+            // views include both ends, a range ends right before the next one starts
+            const ros::Time end = i + 1 < _file->part_starts.size()
+                                      ? _file->part_starts[i + 1] - ros::Duration(0, 1)
+                                      : _file->end;
+            if (end < _file->part_starts[i]) {
+                return;
+            }
+            rosbag::View view;
+            add_query(view, _bag, _file->topics, _file->part_starts[i], end);
+            for (const rosbag::MessageInstance& message : view) {
+                _buffer.resize(message.size());
+                ros::serialization::OStream stream(_buffer.data(), _buffer.size());
+                message.write(stream);
+                visit(
+                    message.getTopic(),
+                    message.getDataType(),
+                    message.getTime(),
+                    _buffer.data(),
+                    _buffer.size()
+                );
+            }
+        }
+
+      private:
+        const std::shared_ptr<const BagFile> _file;
+        rosbag::Bag _bag;
+        std::vector<uint8_t> _buffer; // serialized message, reused
+    };
+} // namespace
+
+OfflineSource open_bag(const std::string& path, const OfflineFilter& filter) {
+    rosbag::Bag bag(path, rosbag::bagmode::Read);
+    rosbag::View all(bag);
+    OfflineSource source;
+    if (all.size() == 0) {
+        ROS_WARN("%s has no messages", path.c_str());
+        return source;
+    }
+
+    auto file = std::make_shared<BagFile>();
+    file->path = path;
+    file->topics.assign(filter.topics.begin(), filter.topics.end());
+    const ros::Time first = all.getBeginTime();
+    const ros::Time start = first + ros::Duration(filter.start);
+    const ros::Time end = std::isinf(filter.end)
+                              ? all.getEndTime()
+                              : std::min(first + ros::Duration(filter.end), all.getEndTime());
+    if (end < start) {
+        ROS_WARN("%s has no messages in the selected time window", path.c_str());
+        return source;
+    }
+    rosbag::View selected;
+    add_query(selected, bag, file->topics, start, end);
+    if (selected.size() == 0) {
+        ROS_WARN("%s has no messages in the selection", path.c_str());
+        return source;
+    }
+
+    // the selection's share of the file, assuming messages of similar size
+    const double selected_size = static_cast<double>(bag.getSize()) *
+                                 static_cast<double>(selected.size()) /
+                                 static_cast<double>(all.size());
+    const auto num_parts = std::max<uint64_t>(static_cast<uint64_t>(selected_size / PART_SIZE), 1);
+    const ros::Time begin = selected.getBeginTime();
+    file->end = selected.getEndTime();
+    const ros::Duration step = (file->end - begin) * (1.0 / static_cast<double>(num_parts));
+    for (uint64_t i = 0; i < num_parts; ++i) {
+        file->part_starts.push_back(begin + step * static_cast<double>(i));
+    }
+    ROS_INFO(
+        "Split %u messages of %s into %zu time ranges of %.3f s",
+        selected.size(),
+        path.c_str(),
+        file->part_starts.size(),
+        step.toSec()
+    );
+
+    source.part_starts = file->part_starts;
+    source.open_reader = [file]() -> OfflinePartReader {
+        auto reader = std::make_shared<RangeReader>(file);
+        return [reader](size_t part, const OfflineVisitor& visit) { reader->read(part, visit); };
+    };
+    return source;
+}
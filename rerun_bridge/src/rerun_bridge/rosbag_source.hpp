@@ -0,0 +1,14 @@
+#pragma once
+
+#include <string>
+
+#include "offline_source.hpp"
+
+/// Open a ROS1 bag for `convert_offline`, reading its index but no messages yet.
+///
+/// The selected messages are split into time ranges of roughly equal duration, about one per
+/// 64 MB, each read through its own `rosbag::View`. Ranges don't overlap, but each reader thread
+/// opens the bag itself since `rosbag::Bag` isn't thread-safe. Messages are visited at their
+/// record time. The filter is applied with topic and time queries on the bag's index, so only
+/// chunks with selected messages are read. Throws rosbag::BagException if the bag can't be read.
+OfflineSource open_bag(const std::string& path, const OfflineFilter& filter = OfflineFilter());
@@ -0,0 +1,308 @@
+#include "shm_log_transport.hpp"
+
+#include <chrono>
+#include <cstring>
+#include <mutex>
+#include <string_view>
+
+#include <boost/make_shared.hpp>
+#include <ros/ros.h>
+#include <ros/serialization.h>
+
+// Every record starts with the timestamp and the entity path, padded so the message or image
+// that follows is 8 byte aligned:
+//   double normalized_timestamp | uint32_t entity_path_size | entity_path | padding | body
+namespace {
+    size_t prefix_size(const std::string& entity_path) {
+        return (sizeof(double) + sizeof(uint32_t) + entity_path.size() + 7) & ~size_t(7);
+    }
+
+    uint8_t* write_prefix(uint8_t* data, const std::string& entity_path, double timestamp) {
+        const auto entity_path_size = static_cast<uint32_t>(entity_path.size());
+        std::memcpy(data, &timestamp, sizeof(timestamp));
+        std::memcpy(data + sizeof(timestamp), &entity_path_size, sizeof(entity_path_size));
+        uint8_t* entity_path_data = data + sizeof(timestamp) + sizeof(entity_path_size);
+        std::memcpy(entity_path_data, entity_path.data(), entity_path.size());
+        return data + prefix_size(entity_path);
+    }
+
+    // Transform batch body, the entity path of the record is empty:
+    //   uint32_t count | padding | 7 doubles (translation, rotation xyzw) per transform |
+    //   (uint32_t entity_path_size | entity_path) per transform
+    constexpr size_t TRANSFORM_VALUES = 7;
+
+    // Image body, followed by the pixels without any row padding.
+    struct ImageHeader {
+        int32_t rows;
+        int32_t cols;
+        int32_t type;
+        float meter;
+    };
+
+    template <typename TMessage>
+    boost::shared_ptr<TMessage> deserialize(const uint8_t* data, size_t size) {
+        auto msg = boost::make_shared<TMessage>();
+        ros::serialization::IStream stream(
+            const_cast<uint8_t*>(data), static_cast<uint32_t>(size)
+        );
+        ros::serialization::deserialize(stream, *msg);
+        return msg;
+    }
+} // namespace
+
+ShmLogWriter::ShmLogWriter(std::unique_ptr<ShmRing> ring)
+    : _name(ring->name()), _ring(std::move(ring)) {}
+
+template <typename TWrite>
+bool ShmLogWriter::_write(ShmRecordKind kind, size_t size, TWrite&& write) {
+    {
+        std::shared_lock<std::shared_mutex> lock(_ring_mutex);
+        ShmRing::Reservation reservation;
+        if (_ring->reserve(static_cast<uint32_t>(kind), size, reservation)) {
+            write(reservation.data);
+            _ring->commit(reservation);
+            return true;
+        }
+    }
+    _reopen_if_consumer_exited();
+    return false;
+}
+
+/// A full ring usually means the aggregator is falling behind, but if it exited the ring is never
+/// consumed again. Checks at most once per second whether a restarted aggregator created a new
+/// ring with the same name (unlinking ours) and switches to it.
+void ShmLogWriter::_reopen_if_consumer_exited() {
+    const auto since_epoch = std::chrono::steady_clock::now().time_since_epoch();
+    const int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(since_epoch).count();
+    int64_t last_check = _last_consumer_check.load(std::memory_order_relaxed);
+    if (now - last_check < 1000000000 ||
+        !_last_consumer_check.compare_exchange_strong(last_check, now)) {
+        return;
+    }
+    uint64_t generation;
+    bool consumer_alive;
+    {
+        std::shared_lock<std::shared_mutex> lock(_ring_mutex);
+        generation = _ring->generation();
+        consumer_alive = _ring->consumer_alive();
+    }
+    auto ring = ShmRing::open(_name);
+    if (ring && ring->generation() != generation) {
+        std::unique_lock<std::shared_mutex> lock(_ring_mutex);
+        _ring = std::move(ring);
+        ROS_INFO("Writing to the ring of the restarted aggregator of %s", _name.c_str());
+    } else if (!consumer_alive) {
+        ROS_WARN_THROTTLE(
+            5.0, "The aggregator of %s exited, dropping data until it's restarted", _name.c_str()
+        );
+    }
+}
+
+template <typename TMessage>
+bool ShmLogWriter::_write_message(
+    ShmRecordKind kind, const std::string& entity_path, const TMessage& msg,
+    double normalized_timestamp
+) {
+    const uint32_t message_size = ros::serialization::serializationLength(msg);
+    return _write(kind, prefix_size(entity_path) + message_size, [&](uint8_t* data) {
+        uint8_t* body = write_prefix(data, entity_path, normalized_timestamp);
+        ros::serialization::OStream stream(body, message_size);
+        ros::serialization::serialize(stream, msg);
+    });
+}
+
+bool ShmLogWriter::log_imu(
+    const std::string& entity_path, const sensor_msgs::Imu& msg, double normalized_timestamp
+) {
+    return _write_message(ShmRecordKind::Imu, entity_path, msg, normalized_timestamp);
+}
+
+bool ShmLogWriter::log_pose_stamped(
+    const std::string& entity_path, const geometry_msgs::PoseStamped& msg,
+    double normalized_timestamp
+) {
+    return _write_message(ShmRecordKind::PoseStamped, entity_path, msg, normalized_timestamp);
+}
+
+bool ShmLogWriter::log_odometry(
+    const std::string& entity_path, const nav_msgs::Odometry& msg, double normalized_timestamp
+) {
+    return _write_message(ShmRecordKind::Odometry, entity_path, msg, normalized_timestamp);
+}
+
+bool ShmLogWriter::log_joint_state(
+    const std::string& entity_path, const sensor_msgs::JointState& msg,
+    double normalized_timestamp
+) {
+    return _write_message(ShmRecordKind::JointState, entity_path, msg, normalized_timestamp);
+}
+
+bool ShmLogWriter::log_camera_info(
+    const std::string& entity_path, const sensor_msgs::CameraInfo& msg,
+    double normalized_timestamp
+) {
+    return _write_message(ShmRecordKind::CameraInfo, entity_path, msg, normalized_timestamp);
+}
+
+bool ShmLogWriter::log_transform(
+    const std::string& entity_path, const geometry_msgs::TransformStamped& msg,
+    double normalized_timestamp
+) {
+    return _write_message(ShmRecordKind::Transform, entity_path, msg, normalized_timestamp);
+}
+
+bool ShmLogWriter::log_transform_batch(
+    const TransformBatch& batch, double normalized_timestamp
+) {
+    const auto count = static_cast<uint32_t>(batch.transforms.size());
+    size_t body_size = 2 * sizeof(uint32_t) + count * TRANSFORM_VALUES * sizeof(double);
+    for (const std::string* entity_path : batch.entity_paths) {
+        body_size += sizeof(uint32_t) + entity_path->size();
+    }
+    const std::string no_entity_path;
+    const size_t record_size = prefix_size(no_entity_path) + body_size;
+    return _write(ShmRecordKind::TransformBatch, record_size, [&](uint8_t* data) {
+        uint8_t* body = write_prefix(data, no_entity_path, normalized_timestamp);
+        std::memcpy(body, &count, sizeof(count));
+        auto* values = reinterpret_cast<double*>(body + 2 * sizeof(uint32_t));
+        for (const auto& transform : batch.transforms) {
+            *values++ = transform.translation.x;
+            *values++ = transform.translation.y;
+            *values++ = transform.translation.z;
+            *values++ = transform.rotation.x;
+            *values++ = transform.rotation.y;
+            *values++ = transform.rotation.z;
+            *values++ = transform.rotation.w;
+        }
+        auto* entity_paths = reinterpret_cast<uint8_t*>(values);
+        for (const std::string* entity_path : batch.entity_paths) {
+            const auto size = static_cast<uint32_t>(entity_path->size());
+            std::memcpy(entity_paths, &size, sizeof(size));
+            std::memcpy(entity_paths + sizeof(size), entity_path->data(), size);
+            entity_paths += sizeof(size) + size;
+        }
+    });
+}
+
+bool ShmLogWriter::log_converted_image(
+    const std::string& entity_path, const ConvertedImage& image, double normalized_timestamp
+) {
+    const cv::Mat& img = image.image;
+    const size_t row_size = img.cols * img.elemSize();
+    const size_t record_size =
+        prefix_size(entity_path) + sizeof(ImageHeader) + img.rows * row_size;
+    return _write(ShmRecordKind::Image, record_size, [&](uint8_t* data) {
+        uint8_t* body = write_prefix(data, entity_path, normalized_timestamp);
+        const ImageHeader header{img.rows, img.cols, img.type(), image.meter};
+        std::memcpy(body, &header, sizeof(header));
+        uint8_t* pixels = body + sizeof(header);
+        for (int row = 0; row < img.rows; ++row) {
+            std::memcpy(pixels + row * row_size, img.ptr(row), row_size);
+        }
+    });
+}
+
+void log_shm_record(
+    const rerun::RecordingStream& rec, uint32_t kind, const uint8_t* data, size_t size
+) {
+    double timestamp;
+    uint32_t entity_path_size;
+    std::memcpy(&timestamp, data, sizeof(timestamp));
+    std::memcpy(&entity_path_size, data + sizeof(timestamp), sizeof(entity_path_size));
+    const std::string entity_path(
+        reinterpret_cast<const char*>(data + sizeof(timestamp) + sizeof(entity_path_size)),
+        entity_path_size
+    );
+    const uint8_t* body = data + prefix_size(entity_path);
+    const size_t body_size = size - prefix_size(entity_path);
+
+    switch (static_cast<ShmRecordKind>(kind)) {
+        case ShmRecordKind::Imu:
+            log_imu(rec, entity_path, deserialize<sensor_msgs::Imu>(body, body_size), timestamp);
+            break;
+        case ShmRecordKind::PoseStamped:
+            log_pose_stamped(
+                rec,
+                entity_path,
+                deserialize<geometry_msgs::PoseStamped>(body, body_size),
+                timestamp
+            );
+            break;
+        case ShmRecordKind::Odometry:
+            log_odometry(
+                rec,
+                entity_path,
+                deserialize<nav_msgs::Odometry>(body, body_size),
+                timestamp
+            );
+            break;
+        case ShmRecordKind::JointState:
+            log_joint_state(
+                rec,
+                entity_path,
+                deserialize<sensor_msgs::JointState>(body, body_size),
+                timestamp
+            );
+            break;
+        case ShmRecordKind::CameraInfo:
+            // NOTE log_camera_info doesn't set the time itself
+            rec.set_time_seconds("timestamp", timestamp);
+            log_camera_info(
+                rec,
+                entity_path,
+                deserialize<sensor_msgs::CameraInfo>(body, body_size),
+                timestamp
+            );
+            break;
+        case ShmRecordKind::Transform:
+            log_transform(
+                rec,
+                entity_path,
+                *deserialize<geometry_msgs::TransformStamped>(body, body_size),
+                timestamp
+            );
+            break;
+        case ShmRecordKind::TransformBatch: {
+            uint32_t count;
+            std::memcpy(&count, body, sizeof(count));
+            const auto* values = reinterpret_cast<const double*>(body + 2 * sizeof(uint32_t));
+            const uint8_t* entity_paths = reinterpret_cast<const uint8_t*>(
+                values + count * TRANSFORM_VALUES
+            );
+            rec.set_time_seconds("timestamp", timestamp);
+            for (uint32_t i = 0; i < count; ++i, values += TRANSFORM_VALUES) {
+                uint32_t size;
+                std::memcpy(&size, entity_paths, sizeof(size));
+                const std::string_view transform_entity_path(
+                    reinterpret_cast<const char*>(entity_paths + sizeof(size)),
+                    size
+                );
+                entity_paths += sizeof(size) + size;
+                geometry_msgs::Transform transform;
+                transform.translation.x = values[0];
+                transform.translation.y = values[1];
+                transform.translation.z = values[2];
+                transform.rotation.x = values[3];
+                transform.rotation.y = values[4];
+                transform.rotation.z = values[5];
+                transform.rotation.w = values[6];
+                rec.log(transform_entity_path, to_transform3d(transform));
+            }
+            break;
+        }
+        case ShmRecordKind::Image: {
+            ImageHeader header;
+            std::memcpy(&header, body, sizeof(header));
+            // borrows the pixels from the ring, they are copied only once by the Rerun SDK
+            auto* pixels = const_cast<uint8_t*>(body + sizeof(header));
+            const ConvertedImage image{
+                cv::Mat(header.rows, header.cols, header.type, pixels),
+                header.meter
+            };
+            log_converted_image(rec, entity_path, image, timestamp);
+            break;
+        }
+        default:
+            ROS_WARN_THROTTLE(1.0, "Skipping shared memory record of unknown kind %u", kind);
+    }
+}
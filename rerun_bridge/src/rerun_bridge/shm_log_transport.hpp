@@ -0,0 +1,89 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+
+#include <geometry_msgs/PoseStamped.h>
+#include <geometry_msgs/TransformStamped.h>
+#include <nav_msgs/Odometry.h>
+#include <sensor_msgs/CameraInfo.h>
+#include <sensor_msgs/Imu.h>
+#include <sensor_msgs/JointState.h>
+#include <rerun.hpp>
+
+#include "rerun_bridge/rerun_ros_interface.hpp"
+#include "shm_ring.hpp"
+#include "transform_batch.hpp"
+
+enum class ShmRecordKind : uint32_t {
+    Imu = 1,
+    PoseStamped,
+    Odometry,
+    CameraInfo,
+    Transform,
+    Image,
+    JointState,
+    TransformBatch,
+};
+
+/// Writes what the log_* functions would log into a ShmRing, to be logged by the aggregator.
+///
+/// Messages are written ROS-serialized, images are written after conversion, so the aggregator
+/// only has to log them. All functions return false if the ring is full and the data was dropped.
+/// Once a restarted aggregator replaced the ring, writers switch to the new one the next time a
+/// record doesn't fit, until then everything written to the orphaned ring is dropped.
+class ShmLogWriter {
+  public:
+    explicit ShmLogWriter(std::unique_ptr<ShmRing> ring);
+
+    bool log_imu(
+        const std::string& entity_path, const sensor_msgs::Imu& msg, double normalized_timestamp
+    );
+    bool log_pose_stamped(
+        const std::string& entity_path, const geometry_msgs::PoseStamped& msg,
+        double normalized_timestamp
+    );
+    bool log_odometry(
+        const std::string& entity_path, const nav_msgs::Odometry& msg, double normalized_timestamp
+    );
+    bool log_joint_state(
+        const std::string& entity_path, const sensor_msgs::JointState& msg,
+        double normalized_timestamp
+    );
+    bool log_camera_info(
+        const std::string& entity_path, const sensor_msgs::CameraInfo& msg,
+        double normalized_timestamp
+    );
+    bool log_transform(
+        const std::string& entity_path, const geometry_msgs::TransformStamped& msg,
+        double normalized_timestamp
+    );
+    bool log_transform_batch(const TransformBatch& batch, double normalized_timestamp);
+    bool log_converted_image(
+        const std::string& entity_path, const ConvertedImage& image, double normalized_timestamp
+    );
+
+  private:
+    /// Reserve a record of `size` bytes, fill it with `write(data)` and commit it.
+    template <typename TWrite>
+    bool _write(ShmRecordKind kind, size_t size, TWrite&& write);
+    template <typename TMessage>
+    bool _write_message(
+        ShmRecordKind kind, const std::string& entity_path, const TMessage& msg,
+        double normalized_timestamp
+    );
+    void _reopen_if_consumer_exited();
+
+    const std::string _name;
+    std::shared_mutex _ring_mutex; // exclusive only to replace `_ring`
+    std::unique_ptr<ShmRing> _ring;
+    std::atomic<int64_t> _last_consumer_check{0}; // steady clock nanoseconds
+};
+
+/// Log a record written by ShmLogWriter, the images are logged straight from `data`.
+void log_shm_record(
+    const rerun::RecordingStream& rec, uint32_t kind, const uint8_t* data, size_t size
+);
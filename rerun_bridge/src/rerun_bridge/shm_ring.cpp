@@ -0,0 +1,208 @@
+#include "shm_ring.hpp"
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+
+namespace {
+    constexpr uint64_t MAGIC = 0x52524252494e4732; // "RRBRING2"
+    constexpr uint32_t PADDING_KIND = 0xffffffff;
+    constexpr size_t RECORDS_OFFSET = 256; // the ring header lives in front of the records
+
+    uint64_t align16(uint64_t size) {
+        return (size + 15) & ~uint64_t(15);
+    }
+} // namespace
+
+struct ShmRing::RingHeader {
+    uint64_t magic;
+    uint64_t capacity;
+    uint64_t generation; // creation time, tells rings with the same name apart
+    int32_t consumer_pid; // of the creating process
+    alignas(64) std::atomic<uint64_t> head; // next position to reserve, shared by all producers
+    alignas(64) std::atomic<uint64_t> tail; // next position to consume
+    alignas(64) std::atomic<uint64_t> dropped;
+};
+
+/// Records are 16 byte aligned, so the space left before wrapping around always fits a header.
+struct ShmRing::RecordHeader {
+    // Set to the record's absolute position on commit. Positions only ever grow, so stale data
+    // from earlier laps never matches the position the consumer waits for.
+    std::atomic<uint64_t> position;
+    uint32_t size; // payload size, without this header and alignment
+    uint32_t kind;
+};
+
+static_assert(
+    std::atomic<uint64_t>::is_always_lock_free, "atomics in shared memory must be lock free"
+);
+
+std::unique_ptr<ShmRing> ShmRing::create(const std::string& name, size_t capacity) {
+    capacity = align16(capacity);
+    const size_t mapped_size = RECORDS_OFFSET + capacity;
+
+    shm_unlink(name.c_str());
+    const int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0 || ftruncate(fd, static_cast<off_t>(mapped_size)) < 0) {
+        const std::string error = strerror(errno);
+        if (fd >= 0) {
+            close(fd);
+        }
+        throw std::runtime_error("Could not create shared memory " + name + ": " + error);
+    }
+    void* memory = mmap(nullptr, mapped_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (memory == MAP_FAILED) {
+        throw std::runtime_error("Could not map shared memory " + name + ": " + strerror(errno));
+    }
+
+    // the memory is zeroed by ftruncate, position 0 would look committed so start a lap later
+    auto* header = new (memory) RingHeader();
+    header->capacity = capacity;
+    header->generation = static_cast<uint64_t>(
+        std::chrono::system_clock::now().time_since_epoch().count()
+    );
+    header->consumer_pid = getpid();
+    header->head = capacity;
+    header->tail = capacity;
+    header->dropped = 0;
+    std::atomic_thread_fence(std::memory_order_release);
+    header->magic = MAGIC;
+
+    return std::unique_ptr<ShmRing>(new ShmRing(name, true, memory, mapped_size));
+}
+
+std::unique_ptr<ShmRing> ShmRing::open(const std::string& name) {
+    const int fd = shm_open(name.c_str(), O_RDWR, 0600);
+    if (fd < 0) {
+        return nullptr;
+    }
+    struct stat info;
+    if (fstat(fd, &info) < 0 || static_cast<size_t>(info.st_size) <= RECORDS_OFFSET) {
+        close(fd);
+        return nullptr;
+    }
+    const auto mapped_size = static_cast<size_t>(info.st_size);
+    void* memory = mmap(nullptr, mapped_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (memory == MAP_FAILED) {
+        return nullptr;
+    }
+    if (static_cast<RingHeader*>(memory)->magic != MAGIC) {
+        // not initialized yet
+        munmap(memory, mapped_size);
+        return nullptr;
+    }
+    return std::unique_ptr<ShmRing>(new ShmRing(name, false, memory, mapped_size));
+}
+
+ShmRing::ShmRing(std::string name, bool owner, void* memory, size_t mapped_size)
+    : _name(std::move(name)),
+      _owner(owner),
+      _memory(memory),
+      _mapped_size(mapped_size),
+      _header(static_cast<RingHeader*>(memory)),
+      _records(static_cast<uint8_t*>(memory) + RECORDS_OFFSET) {}
+
+ShmRing::~ShmRing() {
+    munmap(_memory, _mapped_size);
+    if (_owner) {
+        shm_unlink(_name.c_str());
+    }
+}
+
+ShmRing::RecordHeader* ShmRing::_record_at(uint64_t position) const {
+    return reinterpret_cast<RecordHeader*>(_records + position % _header->capacity);
+}
+
+bool ShmRing::reserve(uint32_t kind, size_t size, Reservation& reservation) {
+    static_assert(sizeof(RecordHeader) == 16, "records are 16 byte aligned");
+    static_assert(sizeof(RingHeader) <= RECORDS_OFFSET);
+
+    const uint64_t capacity = _header->capacity;
+    const uint64_t record_size = align16(sizeof(RecordHeader) + size);
+    if (record_size > capacity) {
+        _header->dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    uint64_t head = _header->head.load(std::memory_order_relaxed);
+    uint64_t padding;
+    do {
+        // records are contiguous, skip the rest of the buffer if the record doesn't fit
+        const uint64_t offset = head % capacity;
+        padding = offset + record_size > capacity ? capacity - offset : 0;
+        if (head + padding + record_size - _header->tail.load(std::memory_order_acquire) >
+            capacity) {
+            _header->dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+    } while (!_header->head.compare_exchange_weak(
+        head,
+        head + padding + record_size,
+        std::memory_order_acq_rel,
+        std::memory_order_relaxed
+    ));
+
+    if (padding > 0) {
+        auto* padding_record = _record_at(head);
+        padding_record->size = static_cast<uint32_t>(padding - sizeof(RecordHeader));
+        padding_record->kind = PADDING_KIND;
+        padding_record->position.store(head, std::memory_order_release);
+    }
+
+    reservation.position = head + padding;
+    auto* record = _record_at(reservation.position);
+    record->size = static_cast<uint32_t>(size);
+    record->kind = kind;
+    reservation.data = reinterpret_cast<uint8_t*>(record) + sizeof(RecordHeader);
+    return true;
+}
+
+void ShmRing::commit(const Reservation& reservation) {
+    auto* record = _record_at(reservation.position);
+    record->position.store(reservation.position, std::memory_order_release);
+}
+
+size_t ShmRing::consume(
+    const std::function<void(uint32_t kind, const uint8_t* data, size_t size)>& consume,
+    size_t max_records
+) {
+    // NOTE A producer that dies between reserve and commit blocks the ring until the consumer
+    //   recreates it.
+    size_t consumed = 0;
+    uint64_t tail = _header->tail.load(std::memory_order_relaxed);
+    while (consumed < max_records) {
+        auto* record = _record_at(tail);
+        if (record->position.load(std::memory_order_acquire) != tail) {
+            break;
+        }
+        if (record->kind != PADDING_KIND) {
+            consume(record->kind, reinterpret_cast<const uint8_t*>(record + 1), record->size);
+            ++consumed;
+        }
+        tail += align16(sizeof(RecordHeader) + record->size);
+        _header->tail.store(tail, std::memory_order_release);
+    }
+    return consumed;
+}
+
+uint64_t ShmRing::dropped() const {
+    return _header->dropped.load(std::memory_order_relaxed);
+}
+
+uint64_t ShmRing::generation() const {
+    return _header->generation;
+}
+
+bool ShmRing::consumer_alive() const {
+    // EPERM means the process exists but belongs to another user
+    return kill(_header->consumer_pid, 0) == 0 || errno == EPERM;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+/// Multi-producer, single-consumer ring buffer of variable-size records in POSIX shared memory.
+///
+/// Producers (possibly in different processes) reserve space with a single compare-and-swap,
+/// write their record in place and commit it. The consumer reads records in reservation order
+/// directly from the shared memory, so payloads are copied exactly once, by the producer.
+/// Producers never block, a record that doesn't fit is dropped and counted instead.
+class ShmRing {
+  public:
+    struct Reservation {
+        uint8_t* data = nullptr;
+        uint64_t position = 0;
+    };
+
+    /// Create a ring with `capacity` bytes of record space, replacing an existing one.
+    /// Meant for the consumer, the ring is removed again when the returned object is destroyed.
+    static std::unique_ptr<ShmRing> create(const std::string& name, size_t capacity);
+
+    /// Open a ring created by `create`, null if it doesn't exist (yet).
+    static std::unique_ptr<ShmRing> open(const std::string& name);
+
+    ~ShmRing();
+
+    ShmRing(const ShmRing&) = delete;
+    ShmRing& operator=(const ShmRing&) = delete;
+
+    /// Reserve a record of `size` bytes, false if the ring is full.
+    /// The record is invisible to the consumer (and blocks all later records) until `commit`.
+    bool reserve(uint32_t kind, size_t size, Reservation& reservation);
+    void commit(const Reservation& reservation);
+
+    /// Call `consume` for up to `max_records` committed records in order, returns the number of
+    /// records consumed. The data is only valid during the call.
+    size_t consume(
+        const std::function<void(uint32_t kind, const uint8_t* data, size_t size)>& consume,
+        size_t max_records
+    );
+
+    /// Number of records dropped because the ring was full, over all producers.
+    uint64_t dropped() const;
+
+    const std::string& name() const {
+        return _name;
+    }
+
+    /// Changes every time a ring with this name is created, e.g., by a restarted consumer.
+    uint64_t generation() const;
+
+    /// Whether the process that created the ring is still running, nothing consumes it otherwise.
+    bool consumer_alive() const;
+
+  private:
+    struct RingHeader;
+    struct RecordHeader;
+
+    ShmRing(std::string name, bool owner, void* memory, size_t mapped_size);
+    RecordHeader* _record_at(uint64_t position) const;
+
+    const std::string _name;
+    const bool _owner;
+    void* const _memory;
+    const size_t _mapped_size;
+    RingHeader* const _header;
+    uint8_t* const _records;
+};
@@ -0,0 +1,54 @@
+#include "stats_logger.hpp"
+
+StatsLogger::StatsLogger(
+    const rerun::RecordingStream& rec, const Metrics& metrics, std::string entity_path
+)
+    : _rec(rec), _metrics(metrics), _entity_path(std::move(entity_path)) {}
+
+void StatsLogger::log_window(double normalized_timestamp) {
+    _rec.set_time_seconds("timestamp", normalized_timestamp);
+
+    const std::array<std::pair<const char*, const Histogram TopicMetrics::*>, 4> histograms = {{
+        {"queue_delay_ms", &TopicMetrics::queue_delay},
+        {"conversion_ms", &TopicMetrics::conversion_time},
+        {"log_ms", &TopicMetrics::log_time},
+        {"latency_ms", &TopicMetrics::latency},
+    }};
+
+    _metrics.for_each_topic([&](const TopicMetrics& metrics) {
+        const std::string entity_path = _entity_path + metrics.topic;
+        auto& previous = _previous[metrics.topic];
+
+        // counters are logged as the number of events in this window
+        auto log_delta = [&](const char* name, uint64_t value, uint64_t& previous_value) {
+            const auto delta = static_cast<double>(value - previous_value);
+            _rec.log(entity_path + "/" + name, rerun::Scalar(delta));
+            previous_value = value;
+        };
+        log_delta("received", metrics.received.load(std::memory_order_relaxed), previous.received);
+        log_delta("dropped", metrics.dropped.load(std::memory_order_relaxed), previous.dropped);
+        log_delta("logged", metrics.logged.load(std::memory_order_relaxed), previous.logged);
+        const auto queue_depth = metrics.queue_depth.load(std::memory_order_relaxed);
+        _rec.log(entity_path + "/queue_depth", rerun::Scalar(static_cast<double>(queue_depth)));
+
+        // histograms are logged as the mean over this window, skipped if there was no sample
+        for (size_t i = 0; i < histograms.size(); ++i) {
+            const Histogram& histogram = metrics.*histograms[i].second;
+            auto& state = previous.histograms[i];
+            const uint64_t count = histogram.count();
+            const double sum = histogram.sum();
+            if (count > state.count) {
+                const double mean = (sum - state.sum) / static_cast<double>(count - state.count);
+                _rec.log(entity_path + "/" + histograms[i].first, rerun::Scalar(1e3 * mean));
+            }
+            state = {count, sum};
+        }
+    });
+
+    const uint64_t tf_failures = _metrics.tf_failures();
+    _rec.log(
+        _entity_path + "/tf/failures",
+        rerun::Scalar(static_cast<double>(tf_failures - _previous_tf_failures))
+    );
+    _previous_tf_failures = tf_failures;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <array>
+#include <map>
+#include <string>
+
+#include <rerun.hpp>
+
+#include "metrics.hpp"
+
+/// Logs the bridge's own metrics into the recording as scalars, one value per window.
+///
+/// Per message, nothing is done beyond the metrics updates that happen anyway. Each call to
+/// `log_window` turns the difference to the previous call into mean latencies and counts, so the
+/// recording shows whether the source, the bridge or the viewer is behind.
+class StatsLogger {
+  public:
+    StatsLogger(
+        const rerun::RecordingStream& rec, const Metrics& metrics,
+        std::string entity_path = "/bridge/stats"
+    );
+
+    /// Log the metrics of the window since the previous call at the given time.
+    void log_window(double normalized_timestamp);
+
+  private:
+    struct HistogramState {
+        uint64_t count = 0;
+        double sum = 0.0;
+    };
+
+    struct TopicState {
+        uint64_t received = 0;
+        uint64_t dropped = 0;
+        uint64_t logged = 0;
+        std::array<HistogramState, 4> histograms;
+    };
+
+    const rerun::RecordingStream& _rec;
+    const Metrics& _metrics;
+    const std::string _entity_path;
+    std::map<std::string, TopicState> _previous;
+    uint64_t _previous_tf_failures = 0;
+};
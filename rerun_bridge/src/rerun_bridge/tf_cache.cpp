@@ -0,0 +1,198 @@
+#include "tf_cache.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
+
+namespace {
+    constexpr size_t INITIAL_CAPACITY = 64;
+
+    // Terms of the SLERP approximation below, the last one is scaled to minimize the error of
+    // the truncated series.
+    constexpr int SLERP_TERMS = 16;
+    constexpr double SLERP_MU = 1.9168648677947;
+
+    struct SlerpCoefficients {
+        double u[SLERP_TERMS] = {};
+        double v[SLERP_TERMS] = {};
+    };
+
+    constexpr SlerpCoefficients slerp_coefficients() {
+        SlerpCoefficients coefficients;
+        for (int i = 1; i <= SLERP_TERMS; ++i) {
+            const double scale = i == SLERP_TERMS ? SLERP_MU : 1.0;
+            coefficients.u[i - 1] = scale / (i * (2.0 * i + 1.0));
+            coefficients.v[i - 1] = scale * i / (2.0 * i + 1.0);
+        }
+        return coefficients;
+    }
+
+    constexpr SlerpCoefficients SLERP = slerp_coefficients();
+
+    /// sin(t * theta) / sin(theta) for cos(theta) = `cos_theta` in [0, 1], i.e., the weight of
+    /// the quaternion at `t` in SLERP. Evaluates the power series in (cos_theta - 1) instead of
+    /// trigonometric functions (D. Eberly, "A Fast and Accurate Algorithm for Computing SLERP"),
+    /// accurate to about 1e-15 for rotations of up to 90 degrees between the two samples and to
+    /// 3e-8 for opposite ones. Identical rotations give the LERP weight `t`.
+    inline double slerp_weight(double t, double cos_theta) {
+        const double x = cos_theta - 1.0;
+        const double t2 = t * t;
+        double c = 1.0;
+        for (int i = SLERP_TERMS - 1; i >= 0; --i) {
+            c = 1.0 + (SLERP.u[i] * t2 - SLERP.v[i]) * x * c;
+        }
+        return t * c;
+    }
+} // namespace
+
+void TfSamples::resize(size_t size) {
+    valid.resize(size);
+    for (auto* values : {&tx, &ty, &tz, &qx, &qy, &qz, &qw}) {
+        values->resize(size);
+    }
+}
+
+void TfCache::Edge::grow() {
+    const size_t capacity = stamps.empty() ? INITIAL_CAPACITY : 2 * stamps.size();
+    auto linearize = [&](auto& values) {
+        std::remove_reference_t<decltype(values)> grown(capacity);
+        for (size_t i = 0; i < size; ++i) {
+            grown[i] = values[index(i)];
+        }
+        values.swap(grown);
+    };
+    // `index` uses the old capacity, so the stamps are linearized last
+    for (auto* values : {&tx, &ty, &tz, &qx, &qy, &qz, &qw}) {
+        linearize(*values);
+    }
+    linearize(stamps);
+    head = 0;
+}
+
+TfCache::TfCache(double history) : _history(static_cast<int64_t>(history * 1e9)) {}
+
+size_t TfCache::slot(const std::string& parent_frame, const std::string& child_frame) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto inserted = _slots.emplace(std::make_pair(parent_frame, child_frame), _edges.size());
+    if (inserted.second) {
+        _edges.emplace_back();
+    }
+    return inserted.first->second;
+}
+
+void TfCache::add(const geometry_msgs::TransformStamped& transform) {
+    const auto stamp = static_cast<int64_t>(transform.header.stamp.toNSec());
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto slot = _slots.find(std::make_pair(transform.header.frame_id, transform.child_frame_id));
+    if (slot == _slots.end()) {
+        // only edges that are looked up are cached
+        return;
+    }
+    Edge& edge = _edges[slot->second];
+
+    if (edge.size > 0 && stamp <= edge.stamps[edge.index(edge.size - 1)]) {
+        // out of order or repeated, tf2 handles those
+        return;
+    }
+    // drop samples that are too old, but keep one before the history to bracket its start
+    while (edge.size > 1 && edge.stamps[edge.index(1)] < stamp - _history) {
+        edge.head = edge.index(1);
+        edge.size--;
+    }
+    if (edge.size == edge.stamps.size()) {
+        edge.grow();
+    }
+
+    const size_t i = edge.index(edge.size++);
+    edge.stamps[i] = stamp;
+    edge.tx[i] = transform.transform.translation.x;
+    edge.ty[i] = transform.transform.translation.y;
+    edge.tz[i] = transform.transform.translation.z;
+    edge.qx[i] = transform.transform.rotation.x;
+    edge.qy[i] = transform.transform.rotation.y;
+    edge.qz[i] = transform.transform.rotation.z;
+    edge.qw[i] = transform.transform.rotation.w;
+}
+
+void TfCache::interpolate(
+    const std::vector<size_t>& slots, const ros::Time& time, TfSamples& samples
+) {
+    const size_t n = slots.size();
+    samples.resize(n);
+    _before.resize(n);
+    _after.resize(n);
+    _ratios.resize(n);
+    const auto stamp = static_cast<int64_t>(time.toNSec());
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        for (size_t s = 0; s < n; ++s) {
+            const Edge& edge = _edges[slots[s]];
+            // first sample at or after `stamp`
+            size_t low = 0;
+            size_t high = edge.size;
+            while (low < high) {
+                const size_t middle = (low + high) / 2;
+                if (edge.stamps[edge.index(middle)] < stamp) {
+                    low = middle + 1;
+                } else {
+                    high = middle;
+                }
+            }
+            if (low == edge.size || (low == 0 && edge.stamps[edge.index(0)] != stamp)) {
+                samples.valid[s] = 0;
+                _ratios[s] = 0.0;
+                continue;
+            }
+            const size_t after = edge.index(low);
+            const size_t before = low == 0 ? after : edge.index(low - 1);
+            const int64_t span = edge.stamps[after] - edge.stamps[before];
+            samples.valid[s] = 1;
+            _ratios[s] = span == 0 ? 0.0
+                                   : static_cast<double>(stamp - edge.stamps[before]) /
+                                         static_cast<double>(span);
+            auto gather = [&](size_t i, TfSamples& to) {
+                to.tx[s] = edge.tx[i];
+                to.ty[s] = edge.ty[i];
+                to.tz[s] = edge.tz[i];
+                to.qx[s] = edge.qx[i];
+                to.qy[s] = edge.qy[i];
+                to.qz[s] = edge.qz[i];
+                to.qw[s] = edge.qw[i];
+            };
+            gather(before, _before);
+            gather(after, _after);
+        }
+    }
+
+    // Branch free and without calls to libm except sqrt, so the loop vectorizes (see the flags
+    // of tf_cache.cpp in CMakeLists.txt). The arrays never overlap, ivdep saves the runtime
+    // checks for that, which are too many for GCC to version the loop. Invalid edges are
+    // interpolated between zeros (or stale values) and ignored by the caller.
+#pragma GCC ivdep
+    for (size_t s = 0; s < n; ++s) {
+        const double r = _ratios[s];
+        samples.tx[s] = _before.tx[s] + r * (_after.tx[s] - _before.tx[s]);
+        samples.ty[s] = _before.ty[s] + r * (_after.ty[s] - _before.ty[s]);
+        samples.tz[s] = _before.tz[s] + r * (_after.tz[s] - _before.tz[s]);
+
+        // take the shorter arc
+        const double dot = _before.qx[s] * _after.qx[s] + _before.qy[s] * _after.qy[s] +
+                           _before.qz[s] * _after.qz[s] + _before.qw[s] * _after.qw[s];
+        const double sign = dot < 0.0 ? -1.0 : 1.0;
+        const double cos_theta = std::abs(dot);
+        const double w0 = slerp_weight(1.0 - r, cos_theta);
+        const double w1 = sign * slerp_weight(r, cos_theta);
+        const double qx = w0 * _before.qx[s] + w1 * _after.qx[s];
+        const double qy = w0 * _before.qy[s] + w1 * _after.qy[s];
+        const double qz = w0 * _before.qz[s] + w1 * _after.qz[s];
+        const double qw = w0 * _before.qw[s] + w1 * _after.qw[s];
+        // the approximation (and rounding) leave the result slightly off unit length, zeros of
+        // invalid edges stay zero
+        const double norm = std::sqrt(std::max(qx * qx + qy * qy + qz * qz + qw * qw, 1e-300));
+        samples.qx[s] = qx / norm;
+        samples.qy[s] = qy / norm;
+        samples.qz[s] = qz / norm;
+        samples.qw[s] = qw / norm;
+    }
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <geometry_msgs/TransformStamped.h>
+#include <ros/ros.h>
+
+/// Interpolated transforms of a batch of edges, in the order they were requested.
+struct TfSamples {
+    std::vector<uint8_t> valid; // 0 if the edge has no samples around the requested time
+    std::vector<double> tx, ty, tz;
+    std::vector<double> qx, qy, qz, qw;
+
+    void resize(size_t size);
+};
+
+/// Recent transforms of individual parent -> child edges, as received on /tf.
+///
+/// Meant for the fixed rate TF logging, which looks up the same edges every tick. Instead of
+/// one tf2_ros::Buffer lookup per frame (global lock, linked list time cache, chain
+/// composition), all edges are bracketed by binary search under one short lock and then
+/// interpolated in a single loop over flat arrays (LERP for translations, a polynomial SLERP
+/// for rotations), which GCC vectorizes with the flags tf_cache.cpp is built with. Chains of
+/// several edges are left to tf2.
+///
+/// Each edge keeps the samples of the last `history` seconds in a ring buffer of structure of
+/// arrays, which grows if the edge is published faster than it fits.
+class TfCache {
+  public:
+    explicit TfCache(double history = 2.0);
+
+    /// Slot of the edge from `parent_frame` to `child_frame`, created on first use.
+    size_t slot(const std::string& parent_frame, const std::string& child_frame);
+
+    void add(const geometry_msgs::TransformStamped& transform);
+
+    /// Interpolate the edges in `slots` at `time` into `samples`. An edge without samples before
+    /// and after `time` is marked invalid, callers fall back to tf2 for it. Not reentrant, only
+    /// call it from one thread at a time.
+    void interpolate(const std::vector<size_t>& slots, const ros::Time& time, TfSamples& samples);
+
+  private:
+    struct Edge {
+        // ring buffer, the oldest sample is at `head`, capacity is a power of two
+        std::vector<int64_t> stamps; // nanoseconds
+        std::vector<double> tx, ty, tz;
+        std::vector<double> qx, qy, qz, qw;
+        size_t head = 0;
+        size_t size = 0;
+
+        size_t index(size_t i) const {
+            return (head + i) & (stamps.size() - 1);
+        }
+        void grow();
+    };
+
+    const int64_t _history;
+    std::mutex _mutex;
+    std::map<std::pair<std::string, std::string>, size_t> _slots;
+    std::vector<Edge> _edges;
+
+    // the two samples around the requested time per edge, gathered under the lock and
+    // interpolated after releasing it
+    TfSamples _before;
+    TfSamples _after;
+    std::vector<double> _ratios;
+};
@@ -0,0 +1,155 @@
+#include "tf_frame_index.hpp"
+
+#include <ros/ros.h>
+
+namespace {
+    /// Whether `entity_path` is `ancestor` or below it.
+    bool is_within(const std::string& entity_path, const std::string& ancestor) {
+        return entity_path.compare(0, ancestor.size(), ancestor) == 0 &&
+               (entity_path.size() == ancestor.size() || entity_path[ancestor.size()] == '/');
+    }
+} // namespace
+
+void TfFrameIndex::add_tree(const YAML::Node& tree) {
+    std::string entity_path;
+    _add_tree(tree, entity_path, "");
+}
+
+/// Add the frames of `node` below `entity_path`, which is extended in place for the children
+/// (instead of concatenating a new string per level) and restored before returning.
+void TfFrameIndex::_add_tree(
+    const YAML::Node& node, std::string& entity_path, const std::string& parent_frame
+) {
+    const size_t parent_size = entity_path.size();
+    for (const auto& child : node) {
+        auto frame = child.first.as<std::string>();
+        auto value = child.second;
+        entity_path.append("/").append(frame);
+        add(frame, parent_frame, entity_path);
+        ROS_DEBUG("Mapping tf frame %s to entity path %s", frame.c_str(), entity_path.c_str());
+        if (value.size() >= 1) {
+            _add_tree(value, entity_path, frame);
+        }
+        entity_path.resize(parent_size);
+    }
+}
+
+void TfFrameIndex::add(
+    const std::string& frame, const std::string& parent_frame, const std::string& entity_path
+) {
+    std::unique_lock<std::shared_mutex> lock(_mutex);
+    _frames[frame] = {parent_frame, entity_path};
+    _version++;
+}
+
+void TfFrameIndex::set_static(const std::string& frame) {
+    std::unique_lock<std::shared_mutex> lock(_mutex);
+    auto known = _frames.find(frame);
+    if (known != _frames.end() && !known->second.is_static) {
+        known->second.is_static = true;
+        _version++;
+    }
+}
+
+std::string TfFrameIndex::entity_path(const std::string& frame, const std::string& parent_frame) {
+    {
+        std::shared_lock<std::shared_mutex> lock(_mutex);
+        auto known = _frames.find(frame);
+        if (known != _frames.end()) {
+            // only roots are moved when they get a parent
+            if (!_discover || !known->second.parent.empty() || parent_frame.empty()) {
+                return known->second.entity_path;
+            }
+        } else if (!_discover) {
+            return {};
+        }
+    }
+    std::unique_lock<std::shared_mutex> lock(_mutex);
+    return _discover_frame(frame, parent_frame);
+}
+
+size_t TfFrameIndex::size() const {
+    std::shared_lock<std::shared_mutex> lock(_mutex);
+    return _frames.size();
+}
+
+std::map<std::string, std::string> TfFrameIndex::entity_paths() const {
+    std::shared_lock<std::shared_mutex> lock(_mutex);
+    std::map<std::string, std::string> entity_paths;
+    for (const auto& [frame, entry] : _frames) {
+        entity_paths.emplace_hint(entity_paths.end(), frame, entry.entity_path);
+    }
+    return entity_paths;
+}
+
+/// Called with the unique lock held, the frame may have been discovered by another thread since
+/// the shared lookup.
+std::string TfFrameIndex::_discover_frame(
+    const std::string& frame, const std::string& parent_frame
+) {
+    if (parent_frame.empty()) {
+        auto known = _frames.find(frame);
+        if (known == _frames.end()) {
+            known = _frames.emplace(frame, Frame{"", "/" + frame}).first;
+            _version++;
+            ROS_INFO("Discovered tf root frame %s", frame.c_str());
+        }
+        return known->second.entity_path;
+    }
+
+    auto parent = _frames.find(parent_frame);
+    if (parent == _frames.end()) {
+        parent = _frames.emplace(parent_frame, Frame{"", "/" + parent_frame}).first;
+        _version++;
+        ROS_INFO("Discovered tf root frame %s", parent_frame.c_str());
+    }
+    const std::string& parent_entity_path = parent->second.entity_path;
+
+    auto known = _frames.find(frame);
+    if (known == _frames.end()) {
+        known = _frames.emplace(frame, Frame{parent_frame, parent_entity_path + "/" + frame}).first;
+        _version++;
+        ROS_INFO(
+            "Discovered tf frame %s, logging it to %s",
+            frame.c_str(),
+            known->second.entity_path.c_str()
+        );
+        return known->second.entity_path;
+    }
+    if (!known->second.parent.empty()) {
+        return known->second.entity_path;
+    }
+
+    // a root got a parent, move it with all its children below the parent
+    if (is_within(parent_entity_path, known->second.entity_path)) {
+        ROS_WARN_THROTTLE(
+            1.0,
+            "Not moving tf frame %s below its descendant %s",
+            frame.c_str(),
+            parent_frame.c_str()
+        );
+        return known->second.entity_path;
+    }
+    const std::string from_entity_path = known->second.entity_path;
+    const std::string to_entity_path = parent_entity_path + "/" + frame;
+    known->second.parent = parent_frame;
+    _move_subtree(from_entity_path, to_entity_path);
+    _version++;
+    ROS_INFO(
+        "Moved tf frame %s from %s to %s",
+        frame.c_str(),
+        from_entity_path.c_str(),
+        to_entity_path.c_str()
+    );
+    return to_entity_path;
+}
+
+void TfFrameIndex::_move_subtree(
+    const std::string& from_entity_path, const std::string& to_entity_path
+) {
+    for (auto& [frame, entry] : _frames) {
+        if (is_within(entry.entity_path, from_entity_path)) {
+            entry.entity_path.replace(0, from_entity_path.size(), to_entity_path);
+        }
+    }
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+
+#include <yaml-cpp/yaml.h>
+
+/// Maps TF frames to entity paths that mirror the TF tree, e.g., "/odom/body/base_link".
+///
+/// Frames are either added up front (the `tf/tree` of the config) or, with discovery enabled,
+/// when they are first seen as child or parent in a TF message. A parent that hasn't been seen
+/// as a child yet becomes a root. Once it shows up as a child, its whole subtree is moved below
+/// its new parent, all other frames keep the parent they were first seen with.
+///
+/// Thread-safe, looking up known frames only takes a shared lock.
+class TfFrameIndex {
+  public:
+    /// Set before the first lookup.
+    void set_discover(bool discover) {
+        _discover = discover;
+    }
+    bool discover() const {
+        return _discover;
+    }
+
+    /// Add all frames of a `tf/tree` config, e.g., {odom: {body: {base_link: {}}}}.
+    void add_tree(const YAML::Node& tree);
+
+    /// Add `frame` with the given entity path, `parent_frame` is empty for roots.
+    void add(
+        const std::string& frame, const std::string& parent_frame, const std::string& entity_path
+    );
+
+    /// Entity path of `frame`, as seen in a transform from `parent_frame`. Discovers the frame
+    /// (and its parent) if needed, returns an empty string for unknown frames otherwise.
+    std::string entity_path(const std::string& frame, const std::string& parent_frame);
+
+    /// Mark a known frame as static, i.e., only published on /tf_static.
+    void set_static(const std::string& frame);
+
+    size_t size() const;
+
+    /// Changes whenever a frame is added, moved or marked static.
+    uint64_t version() const {
+        return _version.load(std::memory_order_acquire);
+    }
+
+    /// Copy of the frame to entity path mapping.
+    std::map<std::string, std::string> entity_paths() const;
+
+    /// Call `visit(frame, parent_frame, entity_path)` for all frames that have a parent and
+    /// aren't static. Holds a shared lock, so `visit` must not discover frames.
+    template <typename TVisit>
+    void for_each_dynamic_frame(TVisit&& visit) const {
+        std::shared_lock<std::shared_mutex> lock(_mutex);
+        for (const auto& [frame, entry] : _frames) {
+            if (!entry.parent.empty() && !entry.is_static) {
+                visit(frame, entry.parent, entry.entity_path);
+            }
+        }
+    }
+
+  private:
+    struct Frame {
+        std::string parent; // empty for roots
+        std::string entity_path;
+        bool is_static = false;
+    };
+
+    void _add_tree(
+        const YAML::Node& node, std::string& entity_path, const std::string& parent_frame
+    );
+    std::string _discover_frame(const std::string& frame, const std::string& parent_frame);
+    void _move_subtree(const std::string& from_entity_path, const std::string& to_entity_path);
+
+    bool _discover = false;
+    mutable std::shared_mutex _mutex;
+    std::map<std::string, Frame> _frames;
+    std::atomic<uint64_t> _version{0};
+};
@@ -0,0 +1,36 @@
+#include "topic_entity_path.hpp"
+
+#include <algorithm>
+
+std::string resolve_entity_path(
+    const std::map<std::string, std::string>& topic_to_entity_path, const std::string& topic
+) {
+    if (topic_to_entity_path.find(topic) != topic_to_entity_path.end()) {
+        return topic_to_entity_path.at(topic);
+    } else {
+        std::string flattened_topic = topic;
+        auto last_slash =
+            (std::find(flattened_topic.rbegin(), flattened_topic.rend(), '/') + 1).base();
+
+        if (last_slash != flattened_topic.begin()) {
+            // keep leading slash and last slash
+            std::replace(flattened_topic.begin() + 1, last_slash, '/', '-');
+        }
+
+        return "/topics" + flattened_topic;
+    }
+}
+
+std::string parent_entity_path(const std::string& entity_path) {
+    auto last_slash = entity_path.rfind('/');
+    if (last_slash == std::string::npos) {
+        return "";
+    }
+    return entity_path.substr(0, last_slash);
+}
+
+bool is_tf_static_topic(const std::string& topic) {
+    const std::string suffix = "/tf_static";
+    return topic.size() >= suffix.size() &&
+           topic.compare(topic.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
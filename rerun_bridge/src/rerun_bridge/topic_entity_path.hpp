@@ -0,0 +1,19 @@
+#pragma once
+
+#include <map>
+#include <string>
+
+/// Convert a topic name to its entity path.
+/// If the topic is explicitly mapped to an entity path, use that.
+/// Otherwise, the topic name will be automatically converted to a flattened entity path like this:
+///   "/one/two/three/four" -> "/topics/one-two-three/four"
+std::string resolve_entity_path(
+    const std::map<std::string, std::string>& topic_to_entity_path, const std::string& topic
+);
+
+/// The entity path one level up, e.g., of the camera an image entity belongs to.
+std::string parent_entity_path(const std::string& entity_path);
+
+/// Whether a TFMessage topic carries static transforms, i.e., is "/tf_static" or a namespaced
+/// variant of it.
+bool is_tf_static_topic(const std::string& topic);
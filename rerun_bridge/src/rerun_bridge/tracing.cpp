@@ -0,0 +1,142 @@
+#include "tracing.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <pthread.h>
+#include <unistd.h>
+
+#include <ros/ros.h>
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    struct TraceEvent {
+        const char* name;
+        const std::string* topic;
+        Clock::time_point start;
+        Clock::time_point end;
+    };
+
+    /// Written only by its thread, read by `Tracer::stop` after recording has been disabled.
+    struct ThreadBuffer {
+        size_t thread_index;
+        std::string thread_name;
+        std::vector<TraceEvent> events;
+        std::atomic<uint64_t> head{0}; // number of events written so far
+    };
+
+    std::mutex buffers_mutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+    size_t buffer_size = 65536;
+    bool started = false;
+    Clock::time_point trace_start;
+
+    ThreadBuffer& thread_buffer() {
+        // buffers are never freed, so they survive their thread and can be written afterwards
+        thread_local ThreadBuffer* buffer = nullptr;
+        if (buffer == nullptr) {
+            std::lock_guard<std::mutex> lock(buffers_mutex);
+            buffers.push_back(std::make_unique<ThreadBuffer>());
+            buffer = buffers.back().get();
+            buffer->thread_index = buffers.size();
+            char name[16] = "";
+            pthread_getname_np(pthread_self(), name, sizeof(name));
+            buffer->thread_name = name;
+            buffer->events.resize(buffer_size);
+        }
+        return *buffer;
+    }
+
+    void write_json_string(std::ostream& out, const std::string& value) {
+        out << '"';
+        for (char c : value) {
+            if (c == '"' || c == '\\') {
+                out << '\\';
+            }
+            out << c;
+        }
+        out << '"';
+    }
+
+    double microseconds_since_start(Clock::time_point time) {
+        return std::chrono::duration<double, std::micro>(time - trace_start).count();
+    }
+} // namespace
+
+void Tracer::start(size_t events_per_thread) {
+    std::lock_guard<std::mutex> lock(buffers_mutex);
+    // Spans that started before a stop are still recorded when they end, so the buffers can never
+    // be reset safely once they exist. Only the first start of a process records anything.
+    if (started) {
+        ROS_WARN("Tracing can only be started once per process, not starting it again");
+        return;
+    }
+    started = true;
+    buffer_size = std::max<size_t>(events_per_thread, 1);
+    trace_start = Clock::now();
+    _enabled = true;
+}
+
+void Tracer::record(
+    const char* name, const std::string* topic, Clock::time_point start, Clock::time_point end
+) {
+    auto& buffer = thread_buffer();
+    const uint64_t head = buffer.head.load(std::memory_order_relaxed);
+    buffer.events[head % buffer.events.size()] = {name, topic, start, end};
+    buffer.head.store(head + 1, std::memory_order_release);
+}
+
+void Tracer::stop(const std::string& path) {
+    // NOTE spans that started before this are still recorded when they end, they may race with
+    //   writing the file below and show up truncated. This is acceptable for a debugging aid.
+    _enabled = false;
+
+    std::ofstream out(path);
+    if (!out) {
+        ROS_ERROR("Could not write trace to %s", path.c_str());
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(buffers_mutex);
+    const int pid = getpid();
+    size_t num_events = 0;
+    // microseconds with nanosecond resolution, the default precision rounds long traces to 10 us
+    out << std::fixed << std::setprecision(3);
+    out << "{\"traceEvents\":[\n";
+    bool first = true;
+    for (const auto& buffer : buffers) {
+        const uint64_t head = buffer->head.load(std::memory_order_acquire);
+        if (head == 0) {
+            continue;
+        }
+        out << (first ? "" : ",\n") << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":" << pid
+            << ",\"tid\":" << buffer->thread_index << ",\"args\":{\"name\":";
+        write_json_string(out, buffer->thread_name + " " + std::to_string(buffer->thread_index));
+        out << "}}";
+        first = false;
+
+        const uint64_t size = buffer->events.size();
+        for (uint64_t i = head > size ? head - size : 0; i < head; ++i) {
+            const auto& event = buffer->events[i % size];
+            out << ",\n{\"ph\":\"X\",\"cat\":\"rerun_bridge\",\"name\":";
+            write_json_string(out, event.name);
+            out << ",\"pid\":" << pid << ",\"tid\":" << buffer->thread_index
+                << ",\"ts\":" << microseconds_since_start(event.start) << ",\"dur\":"
+                << std::chrono::duration<double, std::micro>(event.end - event.start).count();
+            if (event.topic != nullptr) {
+                out << ",\"args\":{\"topic\":";
+                write_json_string(out, *event.topic);
+                out << "}";
+            }
+            out << "}";
+            ++num_events;
+        }
+    }
+    out << "\n]}\n";
+    ROS_INFO("Wrote %zu trace events to %s", num_events, path.c_str());
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+/// Scoped spans recorded into per-thread ring buffers and written as a Chrome trace.
+///
+/// The resulting JSON can be opened in chrome://tracing or https://ui.perfetto.dev. While tracing
+/// is disabled a span costs a single relaxed atomic load. While enabled, each thread writes into
+/// its own fixed-size ring buffer without locking, keeping the most recent events.
+class Tracer {
+  public:
+    static bool enabled() {
+        return _enabled.load(std::memory_order_relaxed);
+    }
+
+    /// Start recording, keeping up to `events_per_thread` per thread. Only once per process,
+    /// later calls (e.g., by a reloaded nodelet) are ignored with a warning.
+    static void start(size_t events_per_thread = 65536);
+
+    /// Stop recording and write all buffered events to `path` in the Chrome trace format.
+    static void stop(const std::string& path);
+
+    /// `name` has to be a string literal and `topic` (if set) has to outlive the tracer.
+    static void record(
+        const char* name, const std::string* topic, std::chrono::steady_clock::time_point start,
+        std::chrono::steady_clock::time_point end
+    );
+
+  private:
+    static inline std::atomic<bool> _enabled{false};
+};
+
+/// Records the time from construction to destruction as a span, if tracing is enabled.
+class TraceSpan {
+  public:
+    explicit TraceSpan(const char* name, const std::string* topic = nullptr)
+        : _name(Tracer::enabled() ? name : nullptr), _topic(topic) {
+        if (_name != nullptr) {
+            _start = std::chrono::steady_clock::now();
+        }
+    }
+
+    ~TraceSpan() {
+        if (_name != nullptr) {
+            Tracer::record(_name, _topic, _start, std::chrono::steady_clock::now());
+        }
+    }
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+  private:
+    const char* const _name; // null if tracing was disabled when the span started
+    const std::string* const _topic;
+    std::chrono::steady_clock::time_point _start;
+};
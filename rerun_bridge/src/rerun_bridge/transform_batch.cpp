@@ -0,0 +1,25 @@
+#include "transform_batch.hpp"
+
+#include "rerun_bridge/rerun_ros_interface.hpp"
+
+void TransformBatch::clear() {
+    entity_paths.clear();
+    transforms.clear();
+}
+
+void TransformBatch::add(
+    const std::string& entity_path, const geometry_msgs::Transform& transform
+) {
+    entity_paths.push_back(&entity_path);
+    transforms.push_back(transform);
+}
+
+void TransformBatch::log(const rerun::RecordingStream& rec, double normalized_timestamp) const {
+    if (transforms.empty()) {
+        return;
+    }
+    rec.set_time_seconds("timestamp", normalized_timestamp);
+    for (size_t i = 0; i < transforms.size(); ++i) {
+        rec.log(*entity_paths[i], to_transform3d(transforms[i]));
+    }
+}
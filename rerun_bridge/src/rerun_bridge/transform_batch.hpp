@@ -0,0 +1,21 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <geometry_msgs/Transform.h>
+#include <rerun.hpp>
+
+/// Transforms of many entities at the same time, e.g., the interpolated TF tree of one tick.
+///
+/// Logged with a single timeline update instead of one per entity, and written to the shared
+/// memory ring as a single record. Rerun has no call for logging several entities at once, so
+/// each transform is still its own log call.
+struct TransformBatch {
+    std::vector<const std::string*> entity_paths; // owned by the caller, valid until logged
+    std::vector<geometry_msgs::Transform> transforms;
+
+    void clear();
+    void add(const std::string& entity_path, const geometry_msgs::Transform& transform);
+    void log(const rerun::RecordingStream& rec, double normalized_timestamp) const;
+};
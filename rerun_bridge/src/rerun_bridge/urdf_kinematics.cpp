@@ -0,0 +1,156 @@
+#include "urdf_kinematics.hpp"
+
+#include <cmath>
+
+#include <ros/ros.h>
+
+#include "topic_entity_path.hpp"
+
+namespace {
+    // Hamilton product a * b
+    geometry_msgs::Quaternion multiply(
+        const geometry_msgs::Quaternion& a, const geometry_msgs::Quaternion& b
+    ) {
+        geometry_msgs::Quaternion q;
+        q.w = a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z;
+        q.x = a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y;
+        q.y = a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x;
+        q.z = a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w;
+        return q;
+    }
+
+    // v' = v + 2 u x (u x v + w v), with u the vector part of the unit quaternion q
+    geometry_msgs::Vector3 rotate(
+        const geometry_msgs::Quaternion& q, const geometry_msgs::Vector3& v
+    ) {
+        const double cx = q.y * v.z - q.z * v.y + q.w * v.x;
+        const double cy = q.z * v.x - q.x * v.z + q.w * v.y;
+        const double cz = q.x * v.y - q.y * v.x + q.w * v.z;
+        geometry_msgs::Vector3 r;
+        r.x = v.x + 2.0 * (q.y * cz - q.z * cy);
+        r.y = v.y + 2.0 * (q.z * cx - q.x * cz);
+        r.z = v.z + 2.0 * (q.x * cy - q.y * cx);
+        return r;
+    }
+
+    UrdfKinematics::Joint to_joint(const urdf::Joint& urdf_joint, const std::string& entity_path) {
+        UrdfKinematics::Joint joint;
+        joint.name = urdf_joint.name;
+        joint.entity_path = entity_path;
+        joint.prismatic = urdf_joint.type == urdf::Joint::PRISMATIC;
+
+        const auto& origin = urdf_joint.parent_to_joint_origin_transform;
+        joint.origin.translation.x = origin.position.x;
+        joint.origin.translation.y = origin.position.y;
+        joint.origin.translation.z = origin.position.z;
+        joint.origin.rotation.x = origin.rotation.x;
+        joint.origin.rotation.y = origin.rotation.y;
+        joint.origin.rotation.z = origin.rotation.z;
+        joint.origin.rotation.w = origin.rotation.w;
+
+        const auto& axis = urdf_joint.axis;
+        const double norm = std::sqrt(axis.x * axis.x + axis.y * axis.y + axis.z * axis.z);
+        if (norm > 0.0) {
+            joint.axis.x = axis.x / norm;
+            joint.axis.y = axis.y / norm;
+            joint.axis.z = axis.z / norm;
+        } else {
+            // the URDF default
+            joint.axis.x = 1.0;
+            joint.axis.y = 0.0;
+            joint.axis.z = 0.0;
+        }
+
+        joint.position_joint = urdf_joint.name;
+        if (urdf_joint.mimic) {
+            joint.position_joint = urdf_joint.mimic->joint_name;
+            joint.multiplier = urdf_joint.mimic->multiplier;
+            joint.offset = urdf_joint.mimic->offset;
+        }
+        return joint;
+    }
+} // namespace
+
+UrdfKinematics::UrdfKinematics(
+    const urdf::ModelInterface& model,
+    const std::map<std::string, std::string>& tf_frame_to_entity_path
+) {
+    for (const auto& [name, urdf_joint] : model.joints_) {
+        auto entity_path = tf_frame_to_entity_path.find(urdf_joint->child_link_name);
+        if (entity_path == tf_frame_to_entity_path.end()) {
+            continue;
+        }
+        // the transform is relative to the parent link, which must be the TF parent as well
+        auto parent = tf_frame_to_entity_path.find(urdf_joint->parent_link_name);
+        if (parent == tf_frame_to_entity_path.end() ||
+            parent->second != parent_entity_path(entity_path->second)) {
+            ROS_WARN(
+                "Not computing transforms for joint %s, its parent link %s isn't the TF parent "
+                "of %s",
+                name.c_str(),
+                urdf_joint->parent_link_name.c_str(),
+                urdf_joint->child_link_name.c_str()
+            );
+            continue;
+        }
+        switch (urdf_joint->type) {
+            case urdf::Joint::REVOLUTE:
+            case urdf::Joint::CONTINUOUS:
+            case urdf::Joint::PRISMATIC:
+                _joints.push_back(to_joint(*urdf_joint, entity_path->second));
+                _frames.insert(urdf_joint->child_link_name);
+                break;
+            case urdf::Joint::FIXED:
+                _fixed_joints.push_back(to_joint(*urdf_joint, entity_path->second));
+                _frames.insert(urdf_joint->child_link_name);
+                break;
+            default:
+                ROS_WARN(
+                    "Not computing transforms for joint %s, only revolute, continuous, prismatic "
+                    "and fixed joints are supported",
+                    name.c_str()
+                );
+        }
+    }
+}
+
+void UrdfKinematics::log_fixed_joints(const rerun::RecordingStream& rec) const {
+    for (const auto& joint : _fixed_joints) {
+        const auto& origin = joint.origin;
+        rec.log_static(
+            joint.entity_path,
+            rerun::Transform3D(
+                rerun::Vector3D(origin.translation.x, origin.translation.y, origin.translation.z),
+                rerun::Quaternion::from_wxyz(
+                    origin.rotation.w,
+                    origin.rotation.x,
+                    origin.rotation.y,
+                    origin.rotation.z
+                )
+            )
+        );
+    }
+}
+
+geometry_msgs::Transform UrdfKinematics::transform(const Joint& joint, double position) {
+    geometry_msgs::Transform transform = joint.origin;
+    if (joint.prismatic) {
+        geometry_msgs::Vector3 offset;
+        offset.x = joint.axis.x * position;
+        offset.y = joint.axis.y * position;
+        offset.z = joint.axis.z * position;
+        const auto rotated = rotate(joint.origin.rotation, offset);
+        transform.translation.x += rotated.x;
+        transform.translation.y += rotated.y;
+        transform.translation.z += rotated.z;
+    } else {
+        const double s = std::sin(0.5 * position);
+        geometry_msgs::Quaternion motion;
+        motion.x = joint.axis.x * s;
+        motion.y = joint.axis.y * s;
+        motion.z = joint.axis.z * s;
+        motion.w = std::cos(0.5 * position);
+        transform.rotation = multiply(joint.origin.rotation, motion);
+    }
+    return transform;
+}
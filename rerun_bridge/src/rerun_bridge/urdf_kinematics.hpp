@@ -0,0 +1,58 @@
+#pragma once
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <geometry_msgs/TransformStamped.h>
+#include <rerun.hpp>
+#include <urdf/model.h>
+
+/// Link transforms computed from a robot's URDF and its joint positions.
+///
+/// Allows logging JointState topics as transforms directly instead of taking the detour through
+/// robot_state_publisher, TF and the fixed rate TF lookups. Only joints whose child and parent
+/// links are a frame and its parent in the TF tree of the yaml config are kept, so the transforms
+/// end up on the same entities.
+class UrdfKinematics {
+  public:
+    struct Joint {
+        std::string name;
+        std::string entity_path; // of the child link
+        bool prismatic = false; // revolute or continuous otherwise
+        geometry_msgs::Transform origin; // from the parent link to the joint frame
+        geometry_msgs::Vector3 axis; // normalized, in the joint frame
+        // mimic joints move with `position_joint`: position = multiplier * its position + offset
+        std::string position_joint;
+        double multiplier = 1.0;
+        double offset = 0.0;
+    };
+
+    UrdfKinematics(
+        const urdf::ModelInterface& model,
+        const std::map<std::string, std::string>& tf_frame_to_entity_path
+    );
+
+    /// The moving joints, floating and planar joints are left to TF.
+    const std::vector<Joint>& joints() const {
+        return _joints;
+    }
+
+    /// Whether the transform of `frame` (from its TF parent) is computed from the joints, i.e.,
+    /// it shouldn't be logged from TF as well.
+    bool computes(const std::string& frame) const {
+        return _frames.count(frame) > 0;
+    }
+
+    /// Log the transforms of the fixed joints as static data, they never change.
+    void log_fixed_joints(const rerun::RecordingStream& rec) const;
+
+    /// The transform from the parent to the child link of `joint` at the given position.
+    static geometry_msgs::Transform transform(const Joint& joint, double position);
+
+  private:
+    std::vector<Joint> _joints;
+    std::vector<Joint> _fixed_joints;
+    std::set<std::string> _frames; // child links of all joints
+};
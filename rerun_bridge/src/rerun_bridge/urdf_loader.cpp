@@ -0,0 +1,386 @@
+#include "urdf_loader.hpp"
+
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <regex>
+#include <set>
+
+#include <ros/package.h>
+#include <ros/ros.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+    // number of segments around the circumference of tessellated cylinders and spheres
+    constexpr int SEGMENTS = 32;
+
+    bool ends_with(const std::string& value, const std::string& suffix) {
+        return value.size() >= suffix.size() &&
+               value.compare(value.size() - suffix.size(), suffix.size(), suffix) == 0;
+    }
+
+    rerun::Transform3D to_transform3d(const urdf::Pose& pose) {
+        return rerun::Transform3D(
+            rerun::Vector3D(pose.position.x, pose.position.y, pose.position.z),
+            rerun::Quaternion::from_wxyz(
+                pose.rotation.w,
+                pose.rotation.x,
+                pose.rotation.y,
+                pose.rotation.z
+            )
+        );
+    }
+
+    /// A cylinder along z, centered at the origin like URDF cylinders.
+    TriangleMesh tessellate_cylinder(float radius, float length) {
+        TriangleMesh mesh;
+        const float half_length = 0.5f * length;
+
+        // side, a bottom and top vertex with a radial normal per segment
+        for (int i = 0; i < SEGMENTS; ++i) {
+            const float angle = 2.0f * static_cast<float>(M_PI) * i / SEGMENTS;
+            const float c = std::cos(angle);
+            const float s = std::sin(angle);
+            mesh.positions.push_back({radius * c, radius * s, -half_length});
+            mesh.positions.push_back({radius * c, radius * s, half_length});
+            mesh.normals.push_back({c, s, 0.0f});
+            mesh.normals.push_back({c, s, 0.0f});
+
+            const uint32_t bottom = 2 * i;
+            const uint32_t next_bottom = 2 * ((i + 1) % SEGMENTS);
+            mesh.triangles.push_back({bottom, next_bottom, bottom + 1});
+            mesh.triangles.push_back({bottom + 1, next_bottom, next_bottom + 1});
+        }
+
+        // caps, a center vertex and a ring with an axial normal each
+        for (const float z : {-half_length, half_length}) {
+            const float normal_z = z < 0.0f ? -1.0f : 1.0f;
+            const auto center = static_cast<uint32_t>(mesh.positions.size());
+            mesh.positions.push_back({0.0f, 0.0f, z});
+            mesh.normals.push_back({0.0f, 0.0f, normal_z});
+            for (int i = 0; i < SEGMENTS; ++i) {
+                const float angle = 2.0f * static_cast<float>(M_PI) * i / SEGMENTS;
+                mesh.positions.push_back({radius * std::cos(angle), radius * std::sin(angle), z});
+                mesh.normals.push_back({0.0f, 0.0f, normal_z});
+
+                const uint32_t current = center + 1 + i;
+                const uint32_t next = center + 1 + (i + 1) % SEGMENTS;
+                if (z < 0.0f) {
+                    mesh.triangles.push_back({center, next, current});
+                } else {
+                    mesh.triangles.push_back({center, current, next});
+                }
+            }
+        }
+        return mesh;
+    }
+
+    TriangleMesh tessellate_sphere(float radius) {
+        TriangleMesh mesh;
+        constexpr int stacks = SEGMENTS / 2;
+
+        // a grid over polar and azimuth angle, the seam is duplicated
+        for (int j = 0; j <= stacks; ++j) {
+            const float polar = static_cast<float>(M_PI) * j / stacks;
+            for (int i = 0; i <= SEGMENTS; ++i) {
+                const float azimuth = 2.0f * static_cast<float>(M_PI) * i / SEGMENTS;
+                const std::array<float, 3> normal = {
+                    std::sin(polar) * std::cos(azimuth),
+                    std::sin(polar) * std::sin(azimuth),
+                    std::cos(polar)
+                };
+                mesh.positions.push_back(
+                    {radius * normal[0], radius * normal[1], radius * normal[2]}
+                );
+                mesh.normals.push_back(normal);
+            }
+        }
+        for (int j = 0; j < stacks; ++j) {
+            for (int i = 0; i < SEGMENTS; ++i) {
+                const uint32_t current = j * (SEGMENTS + 1) + i;
+                const uint32_t below = current + SEGMENTS + 1;
+                mesh.triangles.push_back({current, below, current + 1});
+                mesh.triangles.push_back({current + 1, below, below + 1});
+            }
+        }
+        return mesh;
+    }
+
+    /// Run xacro on `path`, returns false if it fails.
+    /// The path is passed as an argument as is, without a shell that would have to quote it.
+    bool expand_xacro(const std::string& path, std::string& urdf) {
+        ROS_INFO("Expanding xacro %s", path.c_str());
+        int fds[2];
+        if (pipe(fds) != 0) {
+            return false;
+        }
+        // prepared before forking, the child of a multithreaded process must not allocate
+        char* const argv[] = {const_cast<char*>("xacro"), const_cast<char*>(path.c_str()), nullptr};
+        const pid_t pid = fork();
+        if (pid == -1) {
+            close(fds[0]);
+            close(fds[1]);
+            return false;
+        }
+        if (pid == 0) {
+            dup2(fds[1], STDOUT_FILENO);
+            close(fds[0]);
+            close(fds[1]);
+            execvp(argv[0], argv);
+            _exit(127);
+        }
+        close(fds[1]);
+        char buffer[4096];
+        ssize_t size;
+        while ((size = read(fds[0], buffer, sizeof(buffer))) != 0) {
+            if (size > 0) {
+                urdf.append(buffer, static_cast<size_t>(size));
+            } else if (errno != EINTR) {
+                break;
+            }
+        }
+        close(fds[0]);
+        int status = 0;
+        while (waitpid(pid, &status, 0) == -1) {
+            if (errno != EINTR) {
+                return false;
+            }
+        }
+        return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    }
+
+    /// Resolve the filename of a xacro include relative to the including file's directory.
+    /// Returns an empty string if it depends on xacro arguments or properties.
+    std::string resolve_include(const std::string& filename, const std::string& directory) {
+        std::string path = filename;
+        const std::string find = "$(find ";
+        if (path.compare(0, find.size(), find) == 0) {
+            const size_t end = path.find(')');
+            if (end == std::string::npos) {
+                return "";
+            }
+            const std::string package = path.substr(find.size(), end - find.size());
+            path = "package://" + package + path.substr(end + 1);
+        }
+        if (path.find("$(") != std::string::npos || path.find("${") != std::string::npos) {
+            return "";
+        }
+        try {
+            path = resolve_ros_path(path);
+        } catch (const std::runtime_error&) {
+            return "";
+        }
+        return path.empty() || path[0] == '/' ? path : directory + "/" + path;
+    }
+
+    /// Append the paths and contents of all files `content` includes (recursively) to `key`.
+    /// Returns false if an include can't be resolved without running xacro.
+    bool append_includes(
+        const std::string& path, const std::string& content, std::set<std::string>& visited,
+        std::string& key
+    ) {
+        static const std::regex include(
+            R"re(<xacro:include\s[^>]*filename\s*=\s*(?:"([^"]*)"|'([^']*)'))re"
+        );
+        const std::string directory = path.substr(0, path.rfind('/'));
+        for (std::sregex_iterator match(content.begin(), content.end(), include), end;
+             match != end;
+             ++match) {
+            const std::string filename = (*match)[1].matched ? (*match)[1] : (*match)[2];
+            const std::string include_path = resolve_include(filename, directory);
+            std::string include_content;
+            if (include_path.empty() || !read_file(include_path, include_content)) {
+                return false;
+            }
+            if (!visited.insert(include_path).second) {
+                continue;
+            }
+            key += include_path + '\n' + include_content + '\n';
+            if (!append_includes(include_path, include_content, visited, key)) {
+                return false;
+            }
+        }
+        return true;
+    }
+} // namespace
+
+std::string resolve_ros_path(const std::string& path) {
+    if (path.find("package://") == 0) {
+        std::string package_name = path.substr(10, path.find('/', 10) - 10);
+        std::string relative_path = path.substr(10 + package_name.size());
+        std::string package_path = ros::package::getPath(package_name);
+        if (package_path.empty()) {
+            throw std::runtime_error(
+                "Could not resolve " + path +
+                ". Replace with relative / absolute path, source the correct ROS environment, or install " +
+                package_name + "."
+            );
+        }
+        return ros::package::getPath(package_name) + relative_path;
+    } else if (path.find("file://") == 0) {
+        return path.substr(7);
+    } else {
+        return path;
+    }
+}
+
+UrdfLoader::UrdfLoader(
+    const std::map<std::string, std::string>& tf_frame_to_entity_path, const std::string& cache_dir
+)
+    : _tf_frame_to_entity_path(tf_frame_to_entity_path),
+      _cache_dir(cache_dir),
+      _mesh_cache(cache_dir) {}
+
+bool UrdfLoader::log(
+    const rerun::RecordingStream& rec, const std::string& file_path, const std::string& entity_path
+) {
+    std::string urdf;
+    if (!_read_urdf(file_path, urdf)) {
+        return false;
+    }
+    urdf::Model model;
+    if (!model.initString(urdf)) {
+        ROS_WARN("Could not parse URDF %s", file_path.c_str());
+        return false;
+    }
+    if (!model.getRoot()) {
+        ROS_WARN("URDF %s has no root link", file_path.c_str());
+        return false;
+    }
+    _log_link(rec, *model.getRoot(), entity_path);
+    return true;
+}
+
+bool UrdfLoader::_read_urdf(const std::string& file_path, std::string& urdf) const {
+    if (!read_file(file_path, urdf)) {
+        ROS_WARN("Could not read URDF %s", file_path.c_str());
+        return false;
+    }
+    if (!ends_with(file_path, ".xacro")) {
+        return true;
+    }
+
+    std::string cache_path;
+    std::string key = urdf;
+    std::set<std::string> visited;
+    if (!_cache_dir.empty() && !append_includes(file_path, urdf, visited, key)) {
+        ROS_INFO("Not caching %s, its includes depend on xacro arguments", file_path.c_str());
+    } else if (!_cache_dir.empty()) {
+        char name[32];
+        std::snprintf(
+            name,
+            sizeof(name),
+            "%016llx.urdf",
+            static_cast<unsigned long long>(content_hash(key))
+        );
+        cache_path = _cache_dir + "/" + name;
+        if (read_file(cache_path, urdf)) {
+            return true;
+        }
+    }
+
+    urdf.clear();
+    if (!expand_xacro(file_path, urdf)) {
+        ROS_WARN("Could not expand xacro %s", file_path.c_str());
+        return false;
+    }
+    if (!cache_path.empty()) {
+        const std::string temporary_path = cache_path + ".tmp" + std::to_string(getpid());
+        std::ofstream(temporary_path, std::ios::binary) << urdf;
+        std::rename(temporary_path.c_str(), cache_path.c_str());
+    }
+    return true;
+}
+
+void UrdfLoader::_log_link(
+    const rerun::RecordingStream& rec, const urdf::Link& link,
+    const std::string& parent_entity_path
+) {
+    std::string entity_path;
+    auto tf_entity_path = _tf_frame_to_entity_path.find(link.name);
+    if (tf_entity_path != _tf_frame_to_entity_path.end()) {
+        entity_path = tf_entity_path->second;
+    } else {
+        // not updated by TF, the link stays where the joint origin puts it
+        entity_path = parent_entity_path + "/" + link.name;
+        if (link.parent_joint) {
+            rec.log_static(
+                entity_path,
+                to_transform3d(link.parent_joint->parent_to_joint_origin_transform)
+            );
+        }
+    }
+
+    for (size_t i = 0; i < link.visual_array.size(); ++i) {
+        _log_visual(rec, *link.visual_array[i], entity_path + "/visual_" + std::to_string(i));
+    }
+    for (const auto& child : link.child_links) {
+        _log_link(rec, *child, entity_path);
+    }
+}
+
+void UrdfLoader::_log_visual(
+    const rerun::RecordingStream& rec, const urdf::Visual& visual, const std::string& entity_path
+) {
+    if (!visual.geometry) {
+        return;
+    }
+    std::optional<uint32_t> color;
+    if (visual.material && visual.material->texture_filename.empty()) {
+        const auto& material_color = visual.material->color;
+        color = to_rgba32(material_color.r, material_color.g, material_color.b, material_color.a);
+    }
+
+    rec.log_static(entity_path, to_transform3d(visual.origin));
+    switch (visual.geometry->type) {
+        case urdf::Geometry::MESH: {
+            const auto& mesh = static_cast<const urdf::Mesh&>(*visual.geometry);
+            const std::string path = resolve_ros_path(mesh.filename);
+            auto loaded = _meshes.find(path);
+            if (loaded == _meshes.end()) {
+                TriangleMesh triangle_mesh;
+                if (!_mesh_cache.load(path, triangle_mesh)) {
+                    return;
+                }
+                loaded = _meshes.emplace(path, std::move(triangle_mesh)).first;
+            }
+            const std::array<float, 3> scale = {
+                static_cast<float>(mesh.scale.x),
+                static_cast<float>(mesh.scale.y),
+                static_cast<float>(mesh.scale.z)
+            };
+            loaded->second.log_static(rec, entity_path, scale, color);
+            break;
+        }
+        case urdf::Geometry::BOX: {
+            const auto& box = static_cast<const urdf::Box&>(*visual.geometry);
+            auto boxes = rerun::Boxes3D::from_half_sizes(
+                {{0.5f * static_cast<float>(box.dim.x),
+                  0.5f * static_cast<float>(box.dim.y),
+                  0.5f * static_cast<float>(box.dim.z)}}
+            );
+            if (color) {
+                boxes = std::move(boxes).with_colors(rerun::Color(*color));
+            }
+            rec.log_static(entity_path, boxes);
+            break;
+        }
+        case urdf::Geometry::CYLINDER: {
+            const auto& cylinder = static_cast<const urdf::Cylinder&>(*visual.geometry);
+            tessellate_cylinder(
+                static_cast<float>(cylinder.radius),
+                static_cast<float>(cylinder.length)
+            )
+                .log_static(rec, entity_path, {1.0f, 1.0f, 1.0f}, color);
+            break;
+        }
+        case urdf::Geometry::SPHERE: {
+            const auto& sphere = static_cast<const urdf::Sphere&>(*visual.geometry);
+            tessellate_sphere(static_cast<float>(sphere.radius))
+                .log_static(rec, entity_path, {1.0f, 1.0f, 1.0f}, color);
+            break;
+        }
+    }
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <map>
+#include <string>
+
+#include <rerun.hpp>
+#include <urdf/model.h>
+
+#include "mesh_cache.hpp"
+
+/// Resolves "package://" and "file://" paths to absolute paths.
+std::string resolve_ros_path(const std::string& path);
+
+/// Logs the visual geometry of a URDF (or xacro) file as static data, in place of Rerun's
+/// external URDF data-loader.
+///
+/// Links that are part of the TF tree are logged below their TF entity path, so they move with
+/// the logged transforms. All other links are attached to their parent link (or, for the root,
+/// to `entity_path`) with the static transform of their joint. Xacro files are expanded once and
+/// the result is cached next to the meshes, keyed by the hash of the xacro file and all files it
+/// includes. Files whose includes depend on xacro arguments are expanded every time.
+class UrdfLoader {
+  public:
+    UrdfLoader(
+        const std::map<std::string, std::string>& tf_frame_to_entity_path,
+        const std::string& cache_dir
+    );
+
+    /// Returns false if the file couldn't be read or parsed.
+    bool log(
+        const rerun::RecordingStream& rec, const std::string& file_path,
+        const std::string& entity_path
+    );
+
+  private:
+    bool _read_urdf(const std::string& file_path, std::string& urdf) const;
+    void _log_link(
+        const rerun::RecordingStream& rec, const urdf::Link& link,
+        const std::string& parent_entity_path
+    );
+    void _log_visual(
+        const rerun::RecordingStream& rec, const urdf::Visual& visual,
+        const std::string& entity_path
+    );
+
+    const std::map<std::string, std::string>& _tf_frame_to_entity_path;
+    const std::string _cache_dir;
+    MeshCache _mesh_cache;
+    std::map<std::string, TriangleMesh> _meshes; // by path, many URDFs reuse meshes
+};
@@ -0,0 +1,9 @@
+#include "visualizer_node.hpp"
+
+int main(int argc, char** argv) {
+    ros::init(argc, argv, "rerun_logger_node");
+    apply_batching_config();
+    RerunLoggerNode node;
+    node.spin();
+    return 0;
+}
@@ -4,48 +4,221 @@
 #include <geometry_msgs/PoseStamped.h>
 #include <nav_msgs/Odometry.h>
 #include <ros/master.h>
-#include <ros/package.h>
+#include <ros/serialization.h>
+#include <ros/xmlrpc_manager.h>
 #include <sensor_msgs/CameraInfo.h>
 #include <sensor_msgs/Image.h>
 #include <sensor_msgs/Imu.h>
+#include <sensor_msgs/JointState.h>
+#include <tf2/exceptions.h>
 #include <tf2_msgs/TFMessage.h>
+#include <urdf/model.h>
 #include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <ctime>
+#include <string_view>
 
-std::string parent_entity_path(const std::string& entity_path) {
-    auto last_slash = entity_path.rfind('/');
+/// CPU time consumed by the calling thread so far.
+double thread_cpu_seconds() {
+    timespec now;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+    return static_cast<double>(now.tv_sec) + static_cast<double>(now.tv_nsec) * 1e-9;
+}
+
+/// The namespace of a topic, i.e., "/camera/left/image" -> "/camera/left".
+/// Used to pair image topics with their sibling CameraInfo topic.
+std::string topic_namespace(const std::string& topic) {
+    auto last_slash = topic.rfind('/');
     if (last_slash == std::string::npos) {
         return "";
     }
-    return entity_path.substr(0, last_slash);
+    return topic.substr(0, last_slash);
 }
 
-std::string resolve_ros_path(const std::string& path) {
-    if (path.find("package://") == 0) {
-        std::string package_name = path.substr(10, path.find('/', 10) - 10);
-        std::string relative_path = path.substr(10 + package_name.size());
-        std::string package_path = ros::package::getPath(package_name);
-        if (package_path.empty()) {
-            throw std::runtime_error(
-                "Could not resolve " + path +
-                ". Replace with relative / absolute path, source the correct ROS environment, or install " +
-                package_name + "."
-            );
+TfFailure classify_tf_failure(const tf2::TransformException& ex) {
+    if (dynamic_cast<const tf2::LookupException*>(&ex)) {
+        return TfFailure::Lookup;
+    } else if (dynamic_cast<const tf2::ConnectivityException*>(&ex)) {
+        return TfFailure::Connectivity;
+    } else if (dynamic_cast<const tf2::ExtrapolationException*>(&ex)) {
+        return TfFailure::Extrapolation;
+    } else if (dynamic_cast<const tf2::InvalidArgumentException*>(&ex)) {
+        return TfFailure::InvalidArgument;
+    } else if (dynamic_cast<const tf2::TimeoutException*>(&ex)) {
+        return TfFailure::Timeout;
+    }
+    return TfFailure::Other;
+}
+
+/// 32-bit FNV-1a, a stable hash so all shards agree on the topic partitioning.
+uint32_t fnv1a(const std::string& value) {
+    uint32_t hash = 2166136261u;
+    for (unsigned char c : value) {
+        hash = (hash ^ c) * 16777619u;
+    }
+    return hash;
+}
+
+/// "$ROS_HOME/rerun_bridge/cache", ROS_HOME defaulting to "~/.ros".
+std::string default_cache_dir() {
+    if (const char* ros_home = std::getenv("ROS_HOME")) {
+        return std::string(ros_home) + "/rerun_bridge/cache";
+    }
+    if (const char* home = std::getenv("HOME")) {
+        return std::string(home) + "/.ros/rerun_bridge/cache";
+    }
+    return "";
+}
+
+/// The `batching` keys of the yaml config and the environment variables the Rerun SDK reads
+/// them from.
+const std::vector<std::pair<std::string, std::string>>& batching_variables() {
+    static const std::vector<std::pair<std::string, std::string>> variables = {
+        {"flush_tick", "RERUN_FLUSH_TICK_SECS"},
+        {"flush_num_bytes", "RERUN_FLUSH_NUM_BYTES"},
+        {"flush_num_rows", "RERUN_FLUSH_NUM_ROWS"},
+    };
+    return variables;
+}
+
+void apply_batching_config() {
+    std::string yaml_path;
+    if (!ros::param::get("~yaml_path", yaml_path)) {
+        return;
+    }
+    const YAML::Node batching = YAML::LoadFile(yaml_path)["batching"];
+    if (!batching) {
+        return;
+    }
+    for (const auto& [key, variable] : batching_variables()) {
+        if (batching[key]) {
+            const auto value = batching[key].as<std::string>();
+            ROS_INFO("Setting %s=%s", variable.c_str(), value.c_str());
+            setenv(variable.c_str(), value.c_str(), 1);
         }
-        return ros::package::getPath(package_name) + relative_path;
-    } else if (path.find("file://") == 0) {
-        return path.substr(7);
-    } else {
-        return path;
     }
 }
 
-RerunLoggerNode::RerunLoggerNode() {
-    _rec.spawn().exit_on_failure();
+/// Create the recording stream with the id from the private `recording_id` parameter (a random
+/// one if it is not set).
+/// NOTE The SDK reads its batching settings from the environment when a stream is created, see
+///   `apply_batching_config`.
+rerun::RecordingStream create_recording_stream(
+    const ros::NodeHandle& nh, std::string& recording_id
+) {
+    nh.getParam("recording_id", recording_id);
+    return rerun::RecordingStream(
+        "rerun_logger_node",
+        // must be null, an empty id is not replaced by a random one
+        recording_id.empty() ? std::string_view() : std::string_view(recording_id)
+    );
+}
+
+/// Parameter namespace holding the time offset shared by all shards of a recording.
+std::string time_offset_param(const std::string& recording_id) {
+    std::string param = "/rerun_bridge/time_offsets/" + recording_id;
+    std::replace_if(
+        param.begin() + 1,
+        param.end(),
+        [](char c) { return !std::isalnum(static_cast<unsigned char>(c)) && c != '/'; },
+        '_'
+    );
+    return param;
+}
+
+/// Whether `node` is currently registered with the master at `uri`, i.e., whether it's the same
+/// process that registered with that URI earlier and not a previous run of the node.
+bool is_registered_at(const std::string& node, const std::string& uri) {
+    XmlRpc::XmlRpcValue request, response, payload;
+    request[0] = ros::this_node::getName();
+    request[1] = node;
+    return ros::master::execute("lookupNode", request, response, payload, false) &&
+           payload.getType() == XmlRpc::XmlRpcValue::TypeString &&
+           static_cast<std::string>(payload) == uri;
+}
+
+/// Time offset shared by all shards of a recording through the parameter server.
+/// Shard 0 sets it to the current time along with its node name and XML-RPC URI, all other
+/// shards wait for an offset written by the shard 0 that's running now. Offsets left behind by
+/// an earlier run with the same recording id (e.g., after a crash) are thereby ignored.
+double shared_time_offset(const std::string& param, int shard) {
+    double time_offset = 0.0;
+    if (shard == 0) {
+        ros::Time::waitForValid();
+        time_offset = ros::Time::now().toSec();
+        // the offset is written before the owner, so a reader that sees this run's owner also
+        // sees this run's offset
+        ros::param::del(param);
+        ros::param::set(param + "/offset", time_offset);
+        ros::param::set(param + "/uri", ros::XMLRPCManager::instance()->getServerURI());
+        ros::param::set(param + "/node", ros::this_node::getName());
+        return time_offset;
+    }
 
-    // Initialize timestamp normalization
-    _time_offset_initialized = false;
-    _time_offset = 0.0;
+    const auto deadline = ros::WallTime::now() + ros::WallDuration(30.0);
+    while (true) {
+        std::string node;
+        std::string uri;
+        if (ros::param::get(param + "/node", node) && ros::param::get(param + "/uri", uri) &&
+            is_registered_at(node, uri) && ros::param::get(param + "/offset", time_offset)) {
+            return time_offset;
+        }
+        if (!ros::ok() || ros::WallTime::now() > deadline) {
+            throw std::runtime_error("Timed out waiting for shard 0 to set " + param);
+        }
+        ros::WallDuration(0.1).sleep();
+    }
+}
+
+/// Open the ring of the aggregator, waiting for it to be started.
+std::unique_ptr<ShmRing> open_shm_ring(const std::string& name) {
+    const auto deadline = ros::WallTime::now() + ros::WallDuration(30.0);
+    auto ring = ShmRing::open(name);
+    while (!ring) {
+        if (!ros::ok() || ros::WallTime::now() > deadline) {
+            throw std::runtime_error("Timed out waiting for the aggregator to create " + name);
+        }
+        ROS_INFO_THROTTLE(5.0, "Waiting for the aggregator to create %s", name.c_str());
+        ros::WallDuration(0.1).sleep();
+        ring = ShmRing::open(name);
+    }
+    ROS_INFO("Logging through shared memory ring %s", name.c_str());
+    return ring;
+}
 
+ros::TransportHints SubscriberOptions::transport_hints() const {
+    ros::TransportHints hints;
+    if (udp) {
+        // prefer UDP, but fall back to TCP for publishers that don't support it
+        hints.udp();
+        if (max_datagram_size > 0) {
+            hints.maxDatagramSize(max_datagram_size);
+        }
+    }
+    hints.tcp().tcpNoDelay(tcp_nodelay);
+    return hints;
+}
+
+SubscriberOptions read_subscriber_options(const YAML::Node& node, const SubscriberOptions& base) {
+    SubscriberOptions options = base;
+    if (node["queue_size"]) {
+        options.queue_size = node["queue_size"].as<uint32_t>();
+    }
+    if (node["tcp_nodelay"]) {
+        options.tcp_nodelay = node["tcp_nodelay"].as<bool>();
+    }
+    if (node["udp"]) {
+        options.udp = node["udp"].as<bool>();
+    }
+    if (node["max_datagram_size"]) {
+        options.max_datagram_size = node["max_datagram_size"].as<int>();
+    }
+    return options;
+}
+
+RerunLoggerNode::RerunLoggerNode(const ros::NodeHandle& nh)
+    : _rec(create_recording_stream(nh, _recording_id)), _nh(nh) {
     // Read additional config from yaml file
     // NOTE We're not using the ROS parameter server for this, because roscpp doesn't support
     //   reading nested data structures.
@@ -54,36 +227,122 @@ RerunLoggerNode::RerunLoggerNode() {
         ROS_INFO("Read yaml config at %s", yaml_path.c_str());
     }
     _read_yaml_config(yaml_path);
-}
 
-double RerunLoggerNode::_normalize_timestamp(const ros::Time& stamp) const {
-    if (!_time_offset_initialized) {
-        _time_offset = stamp.toSec();
+    if (_num_shards > 1) {
+        if (_recording_id.empty()) {
+            throw std::runtime_error("Sharding requires all shards to set the same ~recording_id");
+        }
+        ROS_INFO("Running as shard %d of %d", _shard, _num_shards);
+        _time_offset = shared_time_offset(time_offset_param(_recording_id), _shard);
         _time_offset_initialized = true;
-        ROS_INFO("Initialized time offset to %.6f", _time_offset);
     }
-    return stamp.toSec() - _time_offset;
-}
 
-/// Convert a topic name to its entity path.
-/// If the topic is explicitly mapped to an entity path, use that.
-/// Otherwise, the topic name will be automatically converted to a flattened entity path like this:
-///   "/one/two/three/four" -> "/topics/one-two-three/four"
-std::string RerunLoggerNode::_resolve_entity_path(const std::string& topic) const {
-    if (_topic_to_entity_path.find(topic) != _topic_to_entity_path.end()) {
-        return _topic_to_entity_path.at(topic);
-    } else {
-        std::string flattened_topic = topic;
-        auto last_slash =
-            (std::find(flattened_topic.rbegin(), flattened_topic.rend(), '/') + 1).base();
+    // With a shared memory ring, messages are logged by the aggregator process instead, `_rec`
+    // is only used for static data and stats.
+    std::string shm_name;
+    if (_nh.getParam("shm_name", shm_name)) {
+        _shm_writer = std::make_unique<ShmLogWriter>(open_shm_ring(shm_name));
+    }
 
-        if (last_slash != flattened_topic.begin()) {
-            // keep leading slash and last slash
-            std::replace(flattened_topic.begin() + 1, last_slash, '/', '-');
+    // Spawn a viewer, unless the recording should be saved to a file instead. Only the first
+    // shard spawns the viewer, all others (and all shards using the aggregator) connect to it.
+    std::string save_path;
+    const bool save = _nh.getParam("save_path", save_path);
+    if (save && _num_shards > 1) {
+        // "recording.rrd" -> "recording.shard1.rrd", the viewer merges them on load
+        auto extension = save_path.rfind('.');
+        if (extension == std::string::npos || extension < save_path.rfind('/') + 1) {
+            extension = save_path.size();
         }
+        save_path.insert(extension, ".shard" + std::to_string(_shard));
+    }
+    const bool spawn = !save && _shard == 0 && !_shm_writer;
+
+    // Setting the sink (spawning the viewer in particular) and logging the static data of the
+    // config can take seconds. Both run in the background, so the subscribers can be created
+    // right away, everything logged before the sink is set is buffered by `_rec`.
+    _sink_thread = std::thread([this, save, save_path, spawn] {
+        const auto start = ros::WallTime::now();
+        if (save) {
+            ROS_INFO("Saving recording to %s", save_path.c_str());
+            _rec.save(save_path).exit_on_failure();
+        } else if (spawn) {
+            _rec.spawn().exit_on_failure();
+        } else {
+            _rec.connect().exit_on_failure();
+        }
+        ROS_INFO("Sink set after %.3f s", (ros::WallTime::now() - start).toSec());
+    });
+    // all shards log into the same recording, so only shard 0 logs the static data
+    if (_shard == 0) {
+        _static_data_thread = std::thread([this] {
+            try {
+                _log_static_data(_static_data_config);
+            } catch (const std::exception& ex) {
+                ROS_ERROR("Could not log the static data of the yaml config: %s", ex.what());
+            }
+        });
+    }
+
+    _image_synchronizer = std::make_unique<ImageSynchronizer>(
+        _image_sync_options,
+        _tf_buffer,
+        _root_frame,
+        _metrics,
+        [this](const ImageSynchronizer::Match& match) { _log_synchronized_image(match); }
+    );
+}
+
+RerunLoggerNode::~RerunLoggerNode() {
+    stop();
+    // subscribers have to be removed from the dedicated callback queues before those are destroyed
+    _topic_to_subscriber.clear();
+    _sink_thread.join();
+    if (_static_data_thread.joinable()) {
+        _static_data_thread.join();
+    }
+}
+
+void RerunLoggerNode::set_message_logged_callback(MessageLoggedCallback callback) {
+    _message_logged_callback = std::move(callback);
+}
+
+/// Run `log`, count the message as logged and report it to the message logged callback, if any.
+/// `prepare_cpu_seconds` is CPU time spent on the message before, e.g., converting an image whose
+/// size has to be known up front, and is included in what's reported.
+template <typename TLog>
+void RerunLoggerNode::_log_instrumented(
+    TopicMetrics& metrics, const ros::Time& stamp, size_t bytes, TLog&& log,
+    double prepare_cpu_seconds
+) const {
+    const double cpu_start =
+        _message_logged_callback ? thread_cpu_seconds() - prepare_cpu_seconds : 0.0;
+    log();
+    if (!_flush_topics.empty() && !_shm_writer && _flush_topics.count(metrics.topic) > 0) {
+        _rec.flush_blocking();
+    }
+    metrics.latency.observe((ros::Time::now() - stamp).toSec());
+    metrics.logged.fetch_add(1, std::memory_order_relaxed);
+    metrics.bytes_logged.fetch_add(bytes, std::memory_order_relaxed);
+    if (_message_logged_callback) {
+        _message_logged_callback(metrics.topic, stamp, thread_cpu_seconds() - cpu_start);
+    }
+}
 
-        return "/topics" + flattened_topic;
+double RerunLoggerNode::_normalize_timestamp(const ros::Time& stamp) const {
+    if (!_time_offset_initialized.load(std::memory_order_acquire)) {
+        std::lock_guard<std::mutex> lock(_time_offset_mutex);
+        if (!_time_offset_initialized.load(std::memory_order_relaxed)) {
+            _time_offset = stamp.toSec();
+            _time_offset_initialized.store(true, std::memory_order_release);
+            ROS_INFO("Initialized time offset to %.6f", _time_offset);
+        }
     }
+    return stamp.toSec() - _time_offset;
+}
+
+std::string RerunLoggerNode::_resolve_entity_path(const std::string& topic) const {
+    return resolve_entity_path(_topic_to_entity_path, topic);
 }
 
 void RerunLoggerNode::_read_yaml_config(std::string yaml_path) {
@@ -98,6 +357,173 @@ void RerunLoggerNode::_read_yaml_config(std::string yaml_path) {
             ROS_INFO("Mapping topic %s to entity path %s", key.c_str(), val.c_str());
         }
     }
+    if (config["tf"]) {
+        if (config["tf"]["update_rate"]) {
+            _tf_fixed_rate = config["tf"]["update_rate"].as<float>();
+        }
+
+        if (config["tf"]["discover"]) {
+            _tf_frames.set_discover(config["tf"]["discover"].as<bool>());
+        }
+
+        if (config["tf"]["tree"]) {
+            // set root frame, all messages with frame_id will be logged relative to this frame
+            _root_frame = config["tf"]["tree"].begin()->first.as<std::string>();
+
+            _tf_frames.add_tree(config["tf"]["tree"]);
+            ROS_INFO("Mapped %zu tf frames to entity paths", _tf_frames.size());
+        }
+        if (config["tf"]["root_frame"]) {
+            _root_frame = config["tf"]["root_frame"].as<std::string>();
+        }
+    }
+
+    if (config["spinner_threads"]) {
+        _spinner_threads = config["spinner_threads"].as<int>();
+    }
+    if (config["callback_queues"]) {
+        for (const auto& callback_queue : config["callback_queues"]) {
+            const auto name = callback_queue.first.as<std::string>();
+            const auto& value = callback_queue.second;
+
+            CallbackQueueSpinner::Options options;
+            if (value["threads"]) {
+                options.threads = value["threads"].as<size_t>();
+            }
+            if (value["cpu_affinity"]) {
+                options.cpu_affinity = value["cpu_affinity"].as<std::vector<int>>();
+            }
+            if (value["types"]) {
+                for (const auto& datatype : value["types"].as<std::vector<std::string>>()) {
+                    _datatype_to_callback_queue[datatype] = name;
+                }
+            }
+            if (value["topics"]) {
+                for (const auto& topic : value["topics"].as<std::vector<std::string>>()) {
+                    _topic_to_callback_queue[topic] = name;
+                }
+            }
+            _callback_queues[name] = std::make_unique<CallbackQueueSpinner>(name, options, _nh);
+        }
+    }
+
+    if (config["subscriber_options"]) {
+        const auto& subscriber_options = config["subscriber_options"];
+        if (subscriber_options["default"]) {
+            _default_subscriber_options =
+                read_subscriber_options(subscriber_options["default"], SubscriberOptions());
+        }
+        if (subscriber_options["types"]) {
+            _datatype_to_subscriber_options =
+                subscriber_options["types"].as<std::map<std::string, YAML::Node>>();
+        }
+        if (subscriber_options["topics"]) {
+            _topic_to_subscriber_options =
+                subscriber_options["topics"].as<std::map<std::string, YAML::Node>>();
+        }
+    }
+
+    if (config["image_sync"]) {
+        const auto& image_sync = config["image_sync"];
+        if (image_sync["camera_info_tolerance"]) {
+            _image_sync_options.camera_info_tolerance =
+                image_sync["camera_info_tolerance"].as<double>();
+        }
+        if (image_sync["max_delay"]) {
+            _image_sync_options.max_delay = image_sync["max_delay"].as<double>();
+        }
+        if (image_sync["max_buffered_images"]) {
+            _image_sync_options.max_buffered_images =
+                image_sync["max_buffered_images"].as<size_t>();
+        }
+        if (image_sync["max_pending_transforms"]) {
+            _image_sync_options.max_pending_transforms =
+                image_sync["max_pending_transforms"].as<size_t>();
+        }
+        if (image_sync["emit_threads"]) {
+            _image_sync_options.emit_threads = image_sync["emit_threads"].as<size_t>();
+        }
+    }
+
+    if (config["batching"] && config["batching"]["flush_topics"]) {
+        const auto flush_topics = config["batching"]["flush_topics"].as<std::vector<std::string>>();
+        _flush_topics.insert(flush_topics.begin(), flush_topics.end());
+    }
+    if (config["batching"]) {
+        // only the standalone node applies these before the stream is created, e.g., a nodelet
+        // would have to change the environment of the whole manager
+        for (const auto& [key, variable] : batching_variables()) {
+            if (config["batching"][key] && std::getenv(variable.c_str()) == nullptr) {
+                ROS_WARN(
+                    "Ignoring batching/%s, set %s in the environment of the process instead",
+                    key.c_str(),
+                    variable.c_str()
+                );
+            }
+        }
+    }
+
+    if (config["sharding"]) {
+        const auto& sharding = config["sharding"];
+        if (sharding["num_shards"]) {
+            _num_shards = std::max(sharding["num_shards"].as<int>(), 1);
+        }
+        if (sharding["topics"]) {
+            _topic_to_shard = sharding["topics"].as<std::map<std::string, int>>();
+        }
+    }
+    // the shard differs per instance and is therefore a ROS parameter, the number of shards can
+    // be set either way so instances can share a config with the unsharded bridge
+    _nh.getParam("num_shards", _num_shards);
+    _nh.getParam("shard", _shard);
+    if (_shard < 0 || _shard >= std::max(_num_shards, 1)) {
+        throw std::runtime_error(
+            "~shard must be in [0, " + std::to_string(_num_shards) + "), got " +
+            std::to_string(_shard)
+        );
+    }
+
+    if (config["metrics"]) {
+        if (config["metrics"]["port"]) {
+            _metrics_port = config["metrics"]["port"].as<int>();
+        }
+        if (config["metrics"]["diagnostics_rate"]) {
+            _diagnostics_rate = config["metrics"]["diagnostics_rate"].as<double>();
+        }
+        if (config["metrics"]["log_stats"]) {
+            _log_stats = config["metrics"]["log_stats"].as<bool>();
+        }
+        if (config["metrics"]["stats_window"]) {
+            _stats_window = config["metrics"]["stats_window"].as<double>();
+        }
+    }
+
+    if (config["tracing"]) {
+        const auto& tracing = config["tracing"];
+        if (tracing["path"]) {
+            _trace_path = tracing["path"].as<std::string>();
+        }
+        if (tracing["events_per_thread"]) {
+            _trace_events_per_thread = tracing["events_per_thread"].as<size_t>();
+        }
+        if (tracing["duration"]) {
+            _trace_duration = tracing["duration"].as<double>();
+        }
+    }
+
+    if (config["joint_states"] && config["joint_states"]["robot_description"]) {
+        const auto param = config["joint_states"]["robot_description"].as<std::string>();
+        if (!param.empty()) {
+            _load_urdf_kinematics(param);
+        }
+    }
+
+    // logged in the background by _log_static_data
+    _static_data_config = config;
+}
+
+/// Log the extra transforms and pinholes and the URDF of the yaml config.
+void RerunLoggerNode::_log_static_data(const YAML::Node& config) const {
     if (config["extra_transform3ds"]) {
         for (const auto& extra_transform3d : config["extra_transform3ds"]) {
             const std::array<float, 3> translation = {
@@ -151,51 +577,147 @@ void RerunLoggerNode::_read_yaml_config(std::string yaml_path) {
             );
         }
     }
-    if (config["tf"]) {
-        if (config["tf"]["update_rate"]) {
-            _tf_fixed_rate = config["tf"]["update_rate"].as<float>();
-        }
-
-        if (config["tf"]["tree"]) {
-            // set root frame, all messages with frame_id will be logged relative to this frame
-            _root_frame = config["tf"]["tree"].begin()->first.as<std::string>();
-
-            // recurse through the tree and add all transforms
-            _add_tf_tree(config["tf"]["tree"], "", "");
-        }
-    }
-
     if (config["urdf"]) {
         std::string urdf_entity_path;
         if (config["urdf"]["entity_path"]) {
             urdf_entity_path = config["urdf"]["entity_path"].as<std::string>();
         }
+        std::string cache_dir = default_cache_dir();
+        if (config["urdf"]["cache_dir"]) {
+            cache_dir = config["urdf"]["cache_dir"].as<std::string>();
+        }
         if (config["urdf"]["file_path"]) {
             std::string urdf_file_path =
                 resolve_ros_path(config["urdf"]["file_path"].as<std::string>());
             ROS_INFO("Logging URDF from file path %s", urdf_file_path.c_str());
-            _rec.log_file_from_path(urdf_file_path, urdf_entity_path, true);
+            const auto start = ros::WallTime::now();
+            // links of frames discovered later stay where the URDF's joints put them
+            const auto tf_frame_to_entity_path = _tf_frames.entity_paths();
+            UrdfLoader loader(tf_frame_to_entity_path, cache_dir);
+            if (loader.log(_rec, urdf_file_path, urdf_entity_path)) {
+                ROS_INFO("Logged URDF in %.3f s", (ros::WallTime::now() - start).toSec());
+            }
         }
     }
 }
 
-void RerunLoggerNode::_add_tf_tree(
-    const YAML::Node& node, const std::string& parent_entity_path, const ::std::string& parent_frame
+/// Load the URDF for computing link transforms from JointState topics.
+/// Needs the TF tree of the config, only links that are part of it get a transform. Their TF
+/// transforms are no longer logged, so the two sources don't alternate on the same entity.
+void RerunLoggerNode::_load_urdf_kinematics(const std::string& robot_description_param) {
+    urdf::Model model;
+    if (!model.initParam(robot_description_param)) {
+        ROS_WARN(
+            "Could not load a URDF from %s, not computing link transforms",
+            robot_description_param.c_str()
+        );
+        return;
+    }
+    _urdf_kinematics = std::make_unique<UrdfKinematics>(model, _tf_frames.entity_paths());
+    if (_shard == 0) {
+        _urdf_kinematics->log_fixed_joints(_rec);
+    }
+    ROS_INFO(
+        "Computing link transforms of %zu joints from %s",
+        _urdf_kinematics->joints().size(),
+        robot_description_param.c_str()
+    );
+}
+
+/// The node handle whose callback queue handles the given topic.
+/// Explicit topic assignments take precedence over assignments by message type.
+ros::NodeHandle& RerunLoggerNode::_node_handle_for(
+    const std::string& topic, const std::string& datatype
 ) {
-    for (const auto& child : node) {
-        auto frame = child.first.as<std::string>();
-        auto value = child.second;
-        const std::string entity_path = parent_entity_path + "/" + frame;
-        _tf_frame_to_entity_path[frame] = entity_path;
-        _tf_frame_to_parent[frame] = parent_frame;
-        ROS_INFO("Mapping tf frame %s to entity path %s", frame.c_str(), entity_path.c_str());
-        if (value.size() >= 1) {
-            _add_tf_tree(value, entity_path, frame);
+    auto queue_name = _topic_to_callback_queue.find(topic);
+    if (queue_name == _topic_to_callback_queue.end()) {
+        queue_name = _datatype_to_callback_queue.find(datatype);
+        if (queue_name == _datatype_to_callback_queue.end()) {
+            return _nh;
         }
     }
+    return _callback_queues.at(queue_name->second)->node_handle();
+}
+
+/// Subscriber options for the given topic.
+/// Starts from the defaults and applies the options for the message type and then those for the
+/// topic on top, so each level only needs to specify the fields it changes.
+SubscriberOptions RerunLoggerNode::_subscriber_options_for(
+    const std::string& topic, const std::string& datatype
+) const {
+    SubscriberOptions options = _default_subscriber_options;
+    auto datatype_options = _datatype_to_subscriber_options.find(datatype);
+    if (datatype_options != _datatype_to_subscriber_options.end()) {
+        options = read_subscriber_options(datatype_options->second, options);
+    }
+    auto topic_options = _topic_to_subscriber_options.find(topic);
+    if (topic_options != _topic_to_subscriber_options.end()) {
+        options = read_subscriber_options(topic_options->second, options);
+    }
+    return options;
+}
+
+/// Subscribe to `topic`, counting received messages, their queueing delay and header sequence
+/// gaps (i.e., messages dropped by a full subscriber queue or the transport) before `callback`.
+template <typename TMessage>
+ros::Subscriber RerunLoggerNode::_subscribe(
+    const std::string& topic,
+    const boost::function<void(const boost::shared_ptr<const TMessage>&)>& callback
+) {
+    const std::string datatype = ros::message_traits::datatype<TMessage>();
+    const auto options = _subscriber_options_for(topic, datatype);
+    auto& metrics = _metrics.topic(topic);
+
+    const boost::function<void(const ros::MessageEvent<const TMessage>&)> instrumented_callback =
+        [&metrics, callback](const ros::MessageEvent<const TMessage>& event) {
+            TraceSpan span("callback", &metrics.topic);
+            metrics.received.fetch_add(1, std::memory_order_relaxed);
+            metrics.queue_delay.observe((ros::Time::now() - event.getReceiptTime()).toSec());
+
+            const auto& msg = event.getConstMessage();
+            if constexpr (ros::message_traits::HasHeader<TMessage>::value) {
+                // NOTE assumes a single publisher per topic, large jumps are treated as restarts
+                const uint32_t seq = msg->header.seq;
+                const uint32_t last_seq = metrics.last_seq.exchange(seq, std::memory_order_relaxed);
+                const uint32_t gap = seq - last_seq - 1;
+                if (last_seq != 0 && seq > last_seq && gap > 0 && gap < 1000) {
+                    metrics.dropped.fetch_add(gap, std::memory_order_relaxed);
+                }
+            }
+            callback(msg);
+        };
+
+    return _node_handle_for(topic, datatype)
+        .subscribe(
+            topic,
+            options.queue_size,
+            instrumented_callback,
+            ros::VoidConstPtr(),
+            options.transport_hints()
+        );
+}
+
+/// Whether this shard logs the given topic.
+/// TF topics always belong to shard 0, which interpolates the transforms at the fixed rate from
+/// what it received itself. Other topics not explicitly assigned to a shard are partitioned by
+/// the hash of their namespace, so an image topic and its CameraInfo end up on the same shard.
+bool RerunLoggerNode::_owns_topic(const std::string& topic, const std::string& datatype) const {
+    if (_num_shards == 1) {
+        return true;
+    }
+    if (datatype == "tf2_msgs/TFMessage") {
+        return _shard == 0;
+    }
+    auto shard = _topic_to_shard.find(topic);
+    if (shard != _topic_to_shard.end()) {
+        return shard->second == _shard;
+    }
+    return fnv1a(topic_namespace(topic)) % static_cast<uint32_t>(_num_shards) ==
+           static_cast<uint32_t>(_shard);
 }
 
 void RerunLoggerNode::_create_subscribers() {
+    TraceSpan span("create_subscribers");
     ros::master::V_TopicInfo topic_infos;
     ros::master::getTopics(topic_infos);
     for (const auto& topic_info : topic_infos) {
@@ -203,6 +725,9 @@ void RerunLoggerNode::_create_subscribers() {
         if (_topic_to_subscriber.find(topic_info.name) != _topic_to_subscriber.end()) {
             continue;
         }
+        if (!_owns_topic(topic_info.name, topic_info.datatype)) {
+            continue;
+        }
 
         if (topic_info.datatype == "sensor_msgs/Image") {
             _topic_to_subscriber[topic_info.name] = _create_image_subscriber(topic_info.name);
@@ -211,17 +736,22 @@ void RerunLoggerNode::_create_subscribers() {
         } else if (topic_info.datatype == "geometry_msgs/PoseStamped") {
             _topic_to_subscriber[topic_info.name] =
                 _create_pose_stamped_subscriber(topic_info.name);
+        } else if (topic_info.datatype == "tf2_msgs/TFMessage" &&
+                   is_tf_static_topic(topic_info.name)) {
+            _topic_to_subscriber[topic_info.name] = _create_tf_static_subscriber(topic_info.name);
         } else if (topic_info.datatype == "tf2_msgs/TFMessage") {
             _topic_to_subscriber[topic_info.name] = _create_tf_message_subscriber(topic_info.name);
         } else if (topic_info.datatype == "nav_msgs/Odometry") {
             _topic_to_subscriber[topic_info.name] = _create_odometry_subscriber(topic_info.name);
         } else if (topic_info.datatype == "sensor_msgs/CameraInfo") {
             _topic_to_subscriber[topic_info.name] = _create_camera_info_subscriber(topic_info.name);
+        } else if (topic_info.datatype == "sensor_msgs/JointState") {
+            _topic_to_subscriber[topic_info.name] = _create_joint_state_subscriber(topic_info.name);
         }
     }
 }
 
-void RerunLoggerNode::_update_tf() const {
+void RerunLoggerNode::_update_tf() {
     // NOTE We log the interpolated transforms with an offset assuming the whole tree has
     //  been updated after this offset. This is not an ideal solution. If a frame is updated
     //  with a delay longer than this offset we will never log interpolated transforms for it.
@@ -230,52 +760,231 @@ void RerunLoggerNode::_update_tf() const {
     //  transform for each frame. However, this would not work if transforms for a frame arrive
     //  out of order (maybe this is not a problem in practice?).
 
+    TraceSpan span("update_tf");
+    const uint64_t version = _tf_frames.version();
+    if (version != _tf_update_version) {
+        _tf_update_version = version;
+        _tf_update_frames.clear();
+        _tf_update_slots.clear();
+        _tf_frames.for_each_dynamic_frame([&](const std::string& frame,
+                                              const std::string& parent_frame,
+                                              const std::string& entity_path) {
+            if (_urdf_kinematics && _urdf_kinematics->computes(frame)) {
+                return;
+            }
+            TfUpdateFrame update_frame;
+            update_frame.entity_path = entity_path;
+            update_frame.transform.header.frame_id = parent_frame;
+            update_frame.transform.child_frame_id = frame;
+            _tf_update_frames.push_back(std::move(update_frame));
+            _tf_update_slots.push_back(_tf_cache.slot(parent_frame, frame));
+        });
+    }
+
     auto now = ros::Time::now();
-    for (const auto& [frame, entity_path] : _tf_frame_to_entity_path) {
-        auto parent = _tf_frame_to_parent.find(frame);
-        if (parent == _tf_frame_to_parent.end() or parent->second.empty()) {
+    const ros::Time time = now - ros::Duration(1.0);
+    _tf_cache.interpolate(_tf_update_slots, time, _tf_samples);
+    _tf_update_batch.clear();
+    for (size_t i = 0; i < _tf_update_frames.size(); ++i) {
+        auto& transform = _tf_update_frames[i].transform;
+        const std::string& entity_path = _tf_update_frames[i].entity_path;
+        if (_tf_samples.valid[i]) {
+            transform.header.stamp = time;
+            transform.transform.translation.x = _tf_samples.tx[i];
+            transform.transform.translation.y = _tf_samples.ty[i];
+            transform.transform.translation.z = _tf_samples.tz[i];
+            transform.transform.rotation.x = _tf_samples.qx[i];
+            transform.transform.rotation.y = _tf_samples.qy[i];
+            transform.transform.rotation.z = _tf_samples.qz[i];
+            transform.transform.rotation.w = _tf_samples.qw[i];
+        } else {
+            try {
+                transform = _tf_buffer.lookupTransform(
+                    transform.header.frame_id,
+                    transform.child_frame_id,
+                    time
+                );
+            } catch (tf2::TransformException& ex) {
+                _metrics.count_tf_failure(classify_tf_failure(ex));
+                ROS_WARN_THROTTLE(
+                    1.0,
+                    "Skipping interpolated logging for %s -> %s because %s",
+                    transform.header.frame_id.c_str(),
+                    transform.child_frame_id.c_str(),
+                    ex.what()
+                );
+                continue;
+            }
+        }
+        _tf_update_batch.add(entity_path, transform.transform);
+    }
+
+    const double normalized_timestamp = _normalize_timestamp(now);
+    TraceSpan log_span("log_transform_batch");
+    if (_shm_writer) {
+        _shm_writer->log_transform_batch(_tf_update_batch, normalized_timestamp);
+    } else {
+        _tf_update_batch.log(_rec, normalized_timestamp);
+    }
+}
+
+void RerunLoggerNode::_count_shm_drop(TopicMetrics& metrics, bool written) const {
+    if (!written) {
+        ROS_WARN_THROTTLE(1.0, "Shared memory ring is full, dropping %s", metrics.topic.c_str());
+        metrics.dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+/// Log each transform to the entity path of its child frame at its own stamp, discovering new
+/// frames if enabled. Consecutive transforms with the same stamp (e.g., all links published by
+/// robot_state_publisher for one joint state) share one timeline update.
+void RerunLoggerNode::_log_tf_message(TopicMetrics& metrics, const tf2_msgs::TFMessage& msg) {
+    const ros::Time* time_stamp = nullptr; // stamp the timeline was last set to
+    double normalized_timestamp = 0.0;
+    const bool interpolate = _tf_fixed_rate != 0.0 && _shard == 0;
+    for (const auto& transform : msg.transforms) {
+        if (interpolate) {
+            _tf_cache.add(transform);
+        }
+        if (_urdf_kinematics && _urdf_kinematics->computes(transform.child_frame_id)) {
             continue;
         }
-        try {
-            auto transform =
-                _tf_buffer.lookupTransform(parent->second, frame, now - ros::Duration(1.0));
-            double normalized_timestamp = _normalize_timestamp(now);
-            log_transform(_rec, entity_path, transform, normalized_timestamp);
-        } catch (tf2::TransformException& ex) {
-            ROS_WARN_THROTTLE(
-                1.0,
-                "Skipping interpolated logging for %s -> %s because %s",
-                parent->second.c_str(),
-                frame.c_str(),
-                ex.what()
+        const std::string entity_path =
+            _tf_frames.entity_path(transform.child_frame_id, transform.header.frame_id);
+        if (entity_path.empty()) {
+            ROS_WARN("No entity path for frame_id %s, skipping", transform.child_frame_id.c_str());
+            continue;
+        }
+
+        if (time_stamp == nullptr || transform.header.stamp != *time_stamp) {
+            time_stamp = &transform.header.stamp;
+            normalized_timestamp = _normalize_timestamp(transform.header.stamp);
+            if (!_shm_writer) {
+                _rec.set_time_seconds("timestamp", normalized_timestamp);
+            }
+        }
+        if (_shm_writer) {
+            _count_shm_drop(
+                metrics,
+                _shm_writer->log_transform(entity_path, transform, normalized_timestamp)
             );
+        } else {
+            _rec.log(entity_path, to_transform3d(transform.transform));
         }
     }
 }
 
+void RerunLoggerNode::_log_synchronized_image(const ImageSynchronizer::Match& match) const {
+    if (!match.image) {
+        const ros::Time& stamp = match.camera_info->header.stamp;
+        auto& metrics = _metrics.topic(match.camera_info_topic);
+        const size_t bytes = ros::serialization::serializationLength(*match.camera_info);
+        _log_instrumented(metrics, stamp, bytes, [&] {
+            double normalized_timestamp = _normalize_timestamp(stamp);
+            ScopedTimer timer(metrics.log_time);
+            TraceSpan span("log_camera_info", &metrics.topic);
+            if (_shm_writer) {
+                _count_shm_drop(
+                    metrics,
+                    _shm_writer->log_camera_info(
+                        match.camera_info_entity_path,
+                        *match.camera_info,
+                        normalized_timestamp
+                    )
+                );
+                return;
+            }
+            // NOTE log_camera_info doesn't set the time itself, and the time set on this emit
+            //   thread belongs to whatever it logged last
+            _rec.set_time_seconds("timestamp", normalized_timestamp);
+            log_camera_info(
+                _rec,
+                match.camera_info_entity_path,
+                match.camera_info,
+                normalized_timestamp
+            );
+        });
+        return;
+    }
+
+    auto& metrics = _metrics.topic(match.image_topic);
+    const double cpu_start = _message_logged_callback ? thread_cpu_seconds() : 0.0;
+    ConvertedImage image;
+    {
+        ScopedTimer timer(metrics.conversion_time);
+        TraceSpan span("convert_image", &metrics.topic);
+        image = convert_image(match.image);
+    }
+    const size_t bytes = image.image.total() * image.image.elemSize();
+    // the conversion is the most expensive part, it's included in the reported CPU time
+    const double conversion_cpu_seconds =
+        _message_logged_callback ? thread_cpu_seconds() - cpu_start : 0.0;
+
+    _log_instrumented(metrics, match.image->header.stamp, bytes, [&] {
+        double normalized_timestamp = _normalize_timestamp(match.image->header.stamp);
+        ScopedTimer timer(metrics.log_time);
+        TraceSpan span("log_image", &metrics.topic);
+        if (_shm_writer) {
+            bool written = true;
+            if (match.transform) {
+                written &= _shm_writer->log_transform(
+                    parent_entity_path(match.image_entity_path),
+                    *match.transform,
+                    normalized_timestamp
+                );
+            }
+            written &= _shm_writer->log_converted_image(
+                match.image_entity_path,
+                image,
+                normalized_timestamp
+            );
+            if (match.camera_info) {
+                written &= _shm_writer->log_camera_info(
+                    match.camera_info_entity_path,
+                    *match.camera_info,
+                    normalized_timestamp
+                );
+            }
+            _count_shm_drop(metrics, written);
+            return;
+        }
+        if (match.transform) {
+            log_transform(
+                _rec,
+                parent_entity_path(match.image_entity_path),
+                *match.transform,
+                normalized_timestamp
+            );
+        }
+        log_converted_image(_rec, match.image_entity_path, image, normalized_timestamp);
+        // NOTE log_camera_info uses the timestamp set by log_converted_image, so it needs to come
+        //   after it
+        if (match.camera_info) {
+            log_camera_info(
+                _rec,
+                match.camera_info_entity_path,
+                match.camera_info,
+                normalized_timestamp
+            );
+        }
+    }, conversion_cpu_seconds);
+}
+
 ros::Subscriber RerunLoggerNode::_create_image_subscriber(const std::string& topic) {
     std::string entity_path = _resolve_entity_path(topic);
+    std::string stream = topic_namespace(topic);
     bool lookup_transform = (_topic_to_entity_path.find(topic) == _topic_to_entity_path.end());
 
-    return _nh.subscribe<sensor_msgs::Image>(
+    return _subscribe<sensor_msgs::Image>(
         topic,
-        100,
-        [&, entity_path, lookup_transform](const sensor_msgs::Image::ConstPtr& msg) {
-            double normalized_timestamp = _normalize_timestamp(msg->header.stamp);
-            if (!_root_frame.empty() && lookup_transform) {
-                try {
-                    auto transform = _tf_buffer.lookupTransform(
-                        _root_frame,
-                        msg->header.frame_id,
-                        msg->header.stamp,
-                        ros::Duration(0.1)
-                    );
-                    log_transform(_rec, parent_entity_path(entity_path), transform, normalized_timestamp);
-                } catch (tf2::TransformException& ex) {
-                    ROS_WARN("%s", ex.what());
-                }
-            }
-            log_image(_rec, entity_path, msg, normalized_timestamp);
+        [&, topic, entity_path, stream, lookup_transform](const sensor_msgs::Image::ConstPtr& msg) {
+            _image_synchronizer->add_image(
+                stream,
+                topic,
+                msg,
+                entity_path,
+                !_root_frame.empty() && lookup_transform
+            );
         }
     );
 }
@@ -283,12 +992,25 @@ ros::Subscriber RerunLoggerNode::_create_image_subscriber(const std::string& top
 ros::Subscriber RerunLoggerNode::_create_imu_subscriber(const std::string& topic) {
     std::string entity_path = _resolve_entity_path(topic);
 
-    return _nh.subscribe<sensor_msgs::Imu>(
+    auto& metrics = _metrics.topic(topic);
+
+    return _subscribe<sensor_msgs::Imu>(
         topic,
-        100,
-        [&, entity_path](const sensor_msgs::Imu::ConstPtr& msg) { 
-            double normalized_timestamp = _normalize_timestamp(msg->header.stamp);
-            log_imu(_rec, entity_path, msg, normalized_timestamp); 
+        [&, entity_path](const sensor_msgs::Imu::ConstPtr& msg) {
+            const size_t bytes = ros::serialization::serializationLength(*msg);
+            _log_instrumented(metrics, msg->header.stamp, bytes, [&] {
+                double normalized_timestamp = _normalize_timestamp(msg->header.stamp);
+                ScopedTimer timer(metrics.log_time);
+                TraceSpan span("log_imu", &metrics.topic);
+                if (_shm_writer) {
+                    _count_shm_drop(
+                        metrics,
+                        _shm_writer->log_imu(entity_path, *msg, normalized_timestamp)
+                    );
+                } else {
+                    log_imu(_rec, entity_path, msg, normalized_timestamp);
+                }
+            });
         }
     );
 }
@@ -296,12 +1018,25 @@ ros::Subscriber RerunLoggerNode::_create_imu_subscriber(const std::string& topic
 ros::Subscriber RerunLoggerNode::_create_pose_stamped_subscriber(const std::string& topic) {
     std::string entity_path = _resolve_entity_path(topic);
 
-    return _nh.subscribe<geometry_msgs::PoseStamped>(
+    auto& metrics = _metrics.topic(topic);
+
+    return _subscribe<geometry_msgs::PoseStamped>(
         topic,
-        100,
         [&, entity_path](const geometry_msgs::PoseStamped::ConstPtr& msg) {
-            double normalized_timestamp = _normalize_timestamp(msg->header.stamp);
-            log_pose_stamped(_rec, entity_path, msg, normalized_timestamp);
+            const size_t bytes = ros::serialization::serializationLength(*msg);
+            _log_instrumented(metrics, msg->header.stamp, bytes, [&] {
+                double normalized_timestamp = _normalize_timestamp(msg->header.stamp);
+                ScopedTimer timer(metrics.log_time);
+                TraceSpan span("log_pose_stamped", &metrics.topic);
+                if (_shm_writer) {
+                    _count_shm_drop(
+                        metrics,
+                        _shm_writer->log_pose_stamped(entity_path, *msg, normalized_timestamp)
+                    );
+                } else {
+                    log_pose_stamped(_rec, entity_path, msg, normalized_timestamp);
+                }
+            });
         }
     );
 }
@@ -309,22 +1044,94 @@ ros::Subscriber RerunLoggerNode::_create_pose_stamped_subscriber(const std::stri
 ros::Subscriber RerunLoggerNode::_create_tf_message_subscriber(const std::string& topic) {
     std::string entity_path = _resolve_entity_path(topic);
 
-    return _nh
-        .subscribe<tf2_msgs::TFMessage>(topic, 100, [&](const tf2_msgs::TFMessage::ConstPtr& msg) {
-            double normalized_timestamp = _normalize_timestamp(msg->transforms[0].header.stamp);
-            log_tf_message(_rec, _tf_frame_to_entity_path, msg, normalized_timestamp);
-        });
+    auto& metrics = _metrics.topic(topic);
+
+    return _subscribe<tf2_msgs::TFMessage>(
+        topic,
+        [&](const tf2_msgs::TFMessage::ConstPtr& msg) {
+            if (msg->transforms.empty()) {
+                return;
+            }
+            // latency is measured to the most recent transform
+            ros::Time stamp = msg->transforms[0].header.stamp;
+            for (const auto& transform : msg->transforms) {
+                stamp = std::max(stamp, transform.header.stamp);
+            }
+            const size_t bytes = ros::serialization::serializationLength(*msg);
+            _log_instrumented(metrics, stamp, bytes, [&] {
+                ScopedTimer timer(metrics.log_time);
+                TraceSpan span("log_tf_message", &metrics.topic);
+                _log_tf_message(metrics, *msg);
+            });
+        }
+    );
+}
+
+/// Static transforms are logged once with log_static, instead of on the timeline each time the
+/// latched message is received again (e.g., when another static broadcaster starts). Their
+/// frames are excluded from the interpolated logging.
+ros::Subscriber RerunLoggerNode::_create_tf_static_subscriber(const std::string& topic) {
+    auto& metrics = _metrics.topic(topic);
+
+    return _subscribe<tf2_msgs::TFMessage>(
+        topic,
+        [&](const tf2_msgs::TFMessage::ConstPtr& msg) {
+            // static transforms are usually stamped with zero, latency is measured from receipt
+            const ros::Time stamp = ros::Time::now();
+            const size_t bytes = ros::serialization::serializationLength(*msg);
+            _log_instrumented(metrics, stamp, bytes, [&] {
+                ScopedTimer timer(metrics.log_time);
+                TraceSpan span("log_tf_static", &metrics.topic);
+                std::lock_guard<std::mutex> lock(_static_transforms_mutex);
+                for (const auto& transform : msg->transforms) {
+                    auto logged = _static_transforms.find(transform.child_frame_id);
+                    if (logged != _static_transforms.end() &&
+                        logged->second == transform.transform) {
+                        continue;
+                    }
+                    const std::string entity_path = _tf_frames.entity_path(
+                        transform.child_frame_id,
+                        transform.header.frame_id
+                    );
+                    if (entity_path.empty()) {
+                        ROS_WARN(
+                            "No entity path for frame_id %s, skipping",
+                            transform.child_frame_id.c_str()
+                        );
+                        continue;
+                    }
+                    _tf_frames.set_static(transform.child_frame_id);
+                    // with shared memory, `_rec` still logs the static data
+                    log_static_transform(_rec, entity_path, transform);
+                    _static_transforms[transform.child_frame_id] = transform.transform;
+                }
+            });
+        }
+    );
 }
 
 ros::Subscriber RerunLoggerNode::_create_odometry_subscriber(const std::string& topic) {
     std::string entity_path = _resolve_entity_path(topic);
 
-    return _nh.subscribe<nav_msgs::Odometry>(
+    auto& metrics = _metrics.topic(topic);
+
+    return _subscribe<nav_msgs::Odometry>(
         topic,
-        100,
         [&, entity_path](const nav_msgs::Odometry::ConstPtr& msg) {
-            double normalized_timestamp = _normalize_timestamp(msg->header.stamp);
-            log_odometry(_rec, entity_path, msg, normalized_timestamp);
+            const size_t bytes = ros::serialization::serializationLength(*msg);
+            _log_instrumented(metrics, msg->header.stamp, bytes, [&] {
+                double normalized_timestamp = _normalize_timestamp(msg->header.stamp);
+                ScopedTimer timer(metrics.log_time);
+                TraceSpan span("log_odometry", &metrics.topic);
+                if (_shm_writer) {
+                    _count_shm_drop(
+                        metrics,
+                        _shm_writer->log_odometry(entity_path, *msg, normalized_timestamp)
+                    );
+                } else {
+                    log_odometry(_rec, entity_path, msg, normalized_timestamp);
+                }
+            });
         }
     );
 }
@@ -338,37 +1145,149 @@ ros::Subscriber RerunLoggerNode::_create_camera_info_subscriber(const std::strin
     if (_topic_to_entity_path.find(topic) == _topic_to_entity_path.end()) {
         entity_path = parent_entity_path(entity_path);
     }
+    std::string stream = topic_namespace(topic);
 
-    return _nh.subscribe<sensor_msgs::CameraInfo>(
+    return _subscribe<sensor_msgs::CameraInfo>(
         topic,
-        100,
-        [&, entity_path](const sensor_msgs::CameraInfo::ConstPtr& msg) {
-            double normalized_timestamp = _normalize_timestamp(msg->header.stamp);
-            log_camera_info(_rec, entity_path, msg, normalized_timestamp);
+        [&, topic, entity_path, stream](const sensor_msgs::CameraInfo::ConstPtr& msg) {
+            _image_synchronizer->add_camera_info(stream, topic, msg, entity_path);
         }
     );
 }
 
-void RerunLoggerNode::spin() {
-    // check for new topics every 0.1 seconds
-    ros::Timer timer =
+ros::Subscriber RerunLoggerNode::_create_joint_state_subscriber(const std::string& topic) {
+    std::string entity_path = _resolve_entity_path(topic);
+    // shared by the copies of the callback, only used by one spinner thread at a time
+    auto joint_state_logger =
+        std::make_shared<JointStateLogger>(entity_path, _urdf_kinematics.get());
+
+    auto& metrics = _metrics.topic(topic);
+
+    return _subscribe<sensor_msgs::JointState>(
+        topic,
+        [&, entity_path, joint_state_logger](const sensor_msgs::JointState::ConstPtr& msg) {
+            const size_t bytes = ros::serialization::serializationLength(*msg);
+            _log_instrumented(metrics, msg->header.stamp, bytes, [&] {
+                double normalized_timestamp = _normalize_timestamp(msg->header.stamp);
+                ScopedTimer timer(metrics.log_time);
+                TraceSpan span("log_joint_state", &metrics.topic);
+                if (_shm_writer) {
+                    bool written =
+                        _shm_writer->log_joint_state(entity_path, *msg, normalized_timestamp);
+                    joint_state_logger->for_each_link_transform(
+                        *msg,
+                        [&](const std::string& link_entity_path,
+                            const geometry_msgs::TransformStamped& transform) {
+                            written &= _shm_writer->log_transform(
+                                link_entity_path,
+                                transform,
+                                normalized_timestamp
+                            );
+                        }
+                    );
+                    _count_shm_drop(metrics, written);
+                    return;
+                }
+                joint_state_logger->log_scalars(_rec, *msg, normalized_timestamp);
+                joint_state_logger->for_each_link_transform(
+                    *msg,
+                    [&](const std::string& link_entity_path,
+                        const geometry_msgs::TransformStamped& transform) {
+                        log_transform(_rec, link_entity_path, transform, normalized_timestamp);
+                    }
+                );
+            });
+        }
+    );
+}
+
+void RerunLoggerNode::start() {
+    if (!_trace_path.empty()) {
+        ROS_INFO("Tracing to %s", _trace_path.c_str());
+        Tracer::start(_trace_events_per_thread);
+        if (_trace_duration > 0.0) {
+            _trace_timer = _nh.createTimer(
+                ros::Duration(_trace_duration),
+                [&](const ros::TimerEvent&) { Tracer::stop(_trace_path); },
+                true
+            );
+        }
+    }
+
+    // subscribe to the topics that already exist right away, then check for new topics every
+    // 0.1 seconds
+    _create_subscribers();
+    _create_subscribers_timer =
         _nh.createTimer(ros::Duration(0.1), [&](const ros::TimerEvent&) { _create_subscribers(); });
 
-    ros::Timer tf_timer;
-    if (_tf_fixed_rate != 0.0) {
-        tf_timer =
-            _nh.createTimer(ros::Duration(1.0 / _tf_fixed_rate), [&](const ros::TimerEvent&) {
+    // the interpolated TF logging shares the callback queue of the TF subscribers, with sharding
+    // it only runs on the first shard (all shards maintain the full TF buffer)
+    if (_tf_fixed_rate != 0.0 && _shard == 0) {
+        auto& nh = _node_handle_for("", "tf2_msgs/TFMessage");
+        _tf_timer =
+            nh.createTimer(ros::Duration(1.0 / _tf_fixed_rate), [&](const ros::TimerEvent&) {
                 _update_tf();
             });
     }
 
-    ros::MultiThreadedSpinner spinner(8); // Use 8 threads
-    spinner.spin();
+    for (auto& [name, callback_queue] : _callback_queues) {
+        callback_queue->start();
+    }
+
+    if (_diagnostics_rate > 0.0) {
+        _diagnostics_publisher = _nh.advertise<diagnostic_msgs::DiagnosticArray>("/diagnostics", 1);
+        _diagnostics_timer =
+            _nh.createTimer(ros::Duration(1.0 / _diagnostics_rate), [&](const ros::TimerEvent&) {
+                _diagnostics_publisher.publish(_metrics.to_diagnostics());
+            });
+    }
+    if (_metrics_port > 0 && !_metrics_server) {
+        try {
+            // shards on the same host serve on consecutive ports
+            _metrics_server = std::make_unique<MetricsServer>(_metrics_port + _shard, [&] {
+                return _metrics.to_prometheus();
+            });
+        } catch (const std::runtime_error& ex) {
+            ROS_ERROR("%s", ex.what());
+        }
+    }
+    if (_log_stats) {
+        if (!_stats_logger) {
+            const std::string entity_path =
+                _num_shards > 1 ? "/bridge/stats/shard" + std::to_string(_shard) : "/bridge/stats";
+            _stats_logger = std::make_unique<StatsLogger>(_rec, _metrics, entity_path);
+        }
+        _stats_timer =
+            _nh.createTimer(ros::Duration(_stats_window), [&](const ros::TimerEvent&) {
+                _stats_logger->log_window(_normalize_timestamp(ros::Time::now()));
+            });
+    }
 }
 
-int main(int argc, char** argv) {
-    ros::init(argc, argv, "rerun_logger_node");
-    RerunLoggerNode node;
-    node.spin();
-    return 0;
+void RerunLoggerNode::stop() {
+    _create_subscribers_timer.stop();
+    _tf_timer.stop();
+    _diagnostics_timer.stop();
+    _stats_timer.stop();
+    _trace_timer.stop();
+    if (!_trace_path.empty() && Tracer::enabled()) {
+        Tracer::stop(_trace_path);
+    }
+    _metrics_server.reset();
+    for (auto& [name, callback_queue] : _callback_queues) {
+        callback_queue->stop();
+    }
+    if (_num_shards > 1 && _shard == 0) {
+        // a later run with the same recording id must not pick up this run's offset
+        ros::param::del(time_offset_param(_recording_id));
+    }
+}
+
+void RerunLoggerNode::spin() {
+    start();
+
+    ros::MultiThreadedSpinner spinner(_spinner_threads);
+    spinner.spin();
+
+    stop();
 }
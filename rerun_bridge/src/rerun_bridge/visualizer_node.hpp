@@ -1,51 +1,204 @@
 #pragma once
 
+#include <atomic>
+#include <functional>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <set>
 #include <string>
+#include <thread>
+#include <vector>
 
+#include <geometry_msgs/Transform.h>
+#include <geometry_msgs/TransformStamped.h>
 #include <ros/ros.h>
+#include <tf2_msgs/TFMessage.h>
 #include <tf2_ros/buffer.h>
 #include <tf2_ros/transform_listener.h>
 #include <yaml-cpp/yaml.h>
 #include <rerun.hpp>
 
+#include "callback_queue_spinner.hpp"
+#include "image_synchronizer.hpp"
+#include "joint_state_logger.hpp"
+#include "metrics.hpp"
+#include "metrics_server.hpp"
+#include "shm_log_transport.hpp"
+#include "stats_logger.hpp"
+#include "tf_cache.hpp"
+#include "tf_frame_index.hpp"
+#include "topic_entity_path.hpp"
+#include "tracing.hpp"
+#include "transform_batch.hpp"
+#include "urdf_loader.hpp"
+#include "urdf_kinematics.hpp"
+
+/// Per-topic subscription settings, trading memory and latency against each other.
+struct SubscriberOptions {
+    uint32_t queue_size = 100;
+    bool tcp_nodelay = false;
+    bool udp = false;
+    int max_datagram_size = 0; // 0 uses the roscpp default
+    ros::TransportHints transport_hints() const;
+};
+
+/// Set the environment variables the Rerun SDK reads its batching settings from to the `batching`
+/// settings of the yaml config in the private `yaml_path` parameter. setenv isn't thread-safe and
+/// changes the whole process, so this is only meant for a standalone node's main, after ros::init
+/// and before any threads are started, e.g., by the first node handle. Nodelets ignore them.
+void apply_batching_config();
+
 class RerunLoggerNode {
   public:
-    RerunLoggerNode();
+    /// All parameters are read from the given (private) node handle, subscribers and timers
+    /// use its callback queue unless assigned to a dedicated one.
+    explicit RerunLoggerNode(const ros::NodeHandle& nh = ros::NodeHandle("~"));
+    ~RerunLoggerNode();
+
+    /// Start topic discovery, TF logging and the dedicated callback queues without blocking.
+    /// The node handle's callback queue has to be spun by the caller (e.g., a nodelet manager).
+    void start();
+    void stop();
+
+    /// Start and spin the global callback queue until ROS shuts down.
     void spin();
 
+    /// Called after each message has been logged, with the CPU time the logging thread spent on
+    /// it. Meant for load testing (see benchmarks/throughput_harness.cpp), set it before start().
+    using MessageLoggedCallback =
+        std::function<void(const std::string& topic, const ros::Time& stamp, double cpu_seconds)>;
+    void set_message_logged_callback(MessageLoggedCallback callback);
+
   private:
     std::map<std::string, std::string> _topic_to_entity_path;
     std::map<std::string, ros::Subscriber> _topic_to_subscriber;
-    std::map<std::string, std::string> _tf_frame_to_entity_path;
-    std::map<std::string, std::string> _tf_frame_to_parent;
+    TfFrameIndex _tf_frames;
+
+    // Last transform logged per static frame, latched /tf_static messages are logged only once
+    std::mutex _static_transforms_mutex;
+    std::map<std::string, geometry_msgs::Transform> _static_transforms;
 
     void _read_yaml_config(std::string yaml_path);
 
     std::string _resolve_entity_path(const std::string& topic) const;
 
-    void _add_tf_tree(const YAML::Node& node, const std::string& parent_entity_path, const std::string& parent_frame);
-
-    const rerun::RecordingStream _rec{"rerun_logger_node"};
-    ros::NodeHandle _nh{"~"};
+    std::string _recording_id; // empty for a random id, declared before `_rec` which uses it
+    const rerun::RecordingStream _rec;
+    ros::NodeHandle _nh;
     std::string _root_frame;
-    float _tf_fixed_rate;
+    float _tf_fixed_rate = 0.0f;
     tf2_ros::Buffer _tf_buffer;
     tf2_ros::TransformListener _tf_listener{_tf_buffer};
     
-    // Timestamp normalization
-    mutable double _time_offset;
-    mutable bool _time_offset_initialized;
+    // Startup work that runs in the background, so subscribers are created without waiting for it
+    std::thread _sink_thread;
+    std::thread _static_data_thread;
+    YAML::Node _static_data_config;
+    void _log_static_data(const YAML::Node& config) const;
+
+    // Topics flushed to the sink right after each message, for latency critical data
+    std::set<std::string> _flush_topics;
+
+    // Sharding, each of `_num_shards` bridge processes logs a disjoint subset of the topics into
+    // the same recording
+    int _shard = 0;
+    int _num_shards = 1;
+    std::map<std::string, int> _topic_to_shard;
+    bool _owns_topic(const std::string& topic, const std::string& datatype) const;
+
+    // Timestamp normalization, the offset is set once (by the first message unless sharded) and
+    // then read by all callback threads, it's only written before `_time_offset_initialized`.
+    mutable std::mutex _time_offset_mutex;
+    mutable double _time_offset = 0.0;
+    mutable std::atomic<bool> _time_offset_initialized{false};
     double _normalize_timestamp(const ros::Time& stamp) const;
 
+    // Metrics are updated from const logging functions, they don't affect the node's state
+    mutable Metrics _metrics;
+    int _metrics_port = 0; // 0 disables the HTTP endpoint
+    double _diagnostics_rate = 0.0; // 0 disables publishing to /diagnostics
+    std::unique_ptr<MetricsServer> _metrics_server;
+    ros::Publisher _diagnostics_publisher;
+    ros::Timer _diagnostics_timer;
+
+    // Self-profiling, logs the metrics to /bridge/stats every `_stats_window` seconds
+    bool _log_stats = false;
+    double _stats_window = 0.1;
+    std::unique_ptr<StatsLogger> _stats_logger;
+    ros::Timer _stats_timer;
+
+    // Tracing, written to `_trace_path` after `_trace_duration` seconds (0 waits for stop())
+    std::string _trace_path;
+    size_t _trace_events_per_thread = 65536;
+    double _trace_duration = 0.0;
+    ros::Timer _trace_timer;
+
+    MessageLoggedCallback _message_logged_callback;
+    template <typename TLog>
+    void _log_instrumented(
+        TopicMetrics& metrics, const ros::Time& stamp, size_t bytes, TLog&& log,
+        double prepare_cpu_seconds = 0.0
+    ) const;
+
+    // Set if messages are handed to the aggregator through shared memory instead of `_rec`
+    std::unique_ptr<ShmLogWriter> _shm_writer;
+    void _count_shm_drop(TopicMetrics& metrics, bool written) const;
+    void _log_tf_message(TopicMetrics& metrics, const tf2_msgs::TFMessage& msg);
+
+    // Link transforms computed from the URDF in `robot_description` and the JointState topics
+    std::unique_ptr<UrdfKinematics> _urdf_kinematics;
+    void _load_urdf_kinematics(const std::string& robot_description_param);
+
+    ImageSynchronizer::Options _image_sync_options;
+    std::unique_ptr<ImageSynchronizer> _image_synchronizer;
+    void _log_synchronized_image(const ImageSynchronizer::Match& match) const;
+
+    // Dedicated callback queues, topics and message types not assigned to any of them are
+    // handled by the global queue with `_spinner_threads` threads.
+    int _spinner_threads = 8;
+    std::map<std::string, std::string> _topic_to_callback_queue;
+    std::map<std::string, std::string> _datatype_to_callback_queue;
+    std::map<std::string, std::unique_ptr<CallbackQueueSpinner>> _callback_queues;
+    ros::NodeHandle& _node_handle_for(const std::string& topic, const std::string& datatype);
+
+    SubscriberOptions _default_subscriber_options;
+    std::map<std::string, YAML::Node> _datatype_to_subscriber_options;
+    std::map<std::string, YAML::Node> _topic_to_subscriber_options;
+    SubscriberOptions _subscriber_options_for(const std::string& topic, const std::string& datatype)
+        const;
+
+    template <typename TMessage>
+    ros::Subscriber _subscribe(
+        const std::string& topic,
+        const boost::function<void(const boost::shared_ptr<const TMessage>&)>& callback
+    );
+
+    ros::Timer _create_subscribers_timer;
+    ros::Timer _tf_timer;
     void _create_subscribers();
-    void _update_tf() const;
+    void _update_tf();
+
+    // Edges interpolated by the fixed rate TF logging, rebuilt when the frame index changes. Edges
+    // that aren't published directly (or lack samples) are looked up through `_tf_buffer`.
+    struct TfUpdateFrame {
+        std::string entity_path;
+        geometry_msgs::TransformStamped transform; // frame ids set, values updated every tick
+    };
+    TfCache _tf_cache;
+    uint64_t _tf_update_version = 0;
+    std::vector<TfUpdateFrame> _tf_update_frames;
+    std::vector<size_t> _tf_update_slots;
+    TfSamples _tf_samples;
+    TransformBatch _tf_update_batch; // logged at once per tick
 
     /* Message specific subscriber factory functions */
     ros::Subscriber _create_image_subscriber(const std::string& topic);
     ros::Subscriber _create_imu_subscriber(const std::string& topic);
     ros::Subscriber _create_pose_stamped_subscriber(const std::string& topic);
     ros::Subscriber _create_tf_message_subscriber(const std::string& topic);
+    ros::Subscriber _create_tf_static_subscriber(const std::string& topic);
     ros::Subscriber _create_odometry_subscriber(const std::string& topic);
     ros::Subscriber _create_camera_info_subscriber(const std::string& topic);
+    ros::Subscriber _create_joint_state_subscriber(const std::string& topic);
 };
@@ -0,0 +1,23 @@
+#include "visualizer_node.hpp"
+
+#include <memory>
+
+#include <nodelet/nodelet.h>
+#include <pluginlib/class_list_macros.h>
+
+/// The bridge as a nodelet.
+///
+/// Loaded into the same manager as the camera / lidar drivers, messages are passed as shared
+/// pointers without any serialization. Callbacks run on the manager's threads, dedicated callback
+/// queues configured in the YAML file still get their own threads.
+class RerunLoggerNodelet : public nodelet::Nodelet {
+  private:
+    void onInit() override {
+        _node = std::make_unique<RerunLoggerNode>(getMTPrivateNodeHandle());
+        _node->start();
+    }
+
+    std::unique_ptr<RerunLoggerNode> _node;
+};
+
+PLUGINLIB_EXPORT_CLASS(RerunLoggerNodelet, nodelet::Nodelet)
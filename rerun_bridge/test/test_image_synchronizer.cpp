@@ -0,0 +1,130 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <vector>
+
+#include <boost/make_shared.hpp>
+
+#include "image_synchronizer.hpp"
+
+namespace {
+    sensor_msgs::Image::ConstPtr image(double stamp) {
+        auto msg = boost::make_shared<sensor_msgs::Image>();
+        msg->header.stamp = ros::Time(stamp);
+        msg->header.frame_id = "camera";
+        return msg;
+    }
+
+    sensor_msgs::CameraInfo::ConstPtr camera_info(double stamp) {
+        auto msg = boost::make_shared<sensor_msgs::CameraInfo>();
+        msg->header.stamp = ros::Time(stamp);
+        msg->header.frame_id = "camera";
+        return msg;
+    }
+
+    /// Collects the matches, which are emitted from several threads.
+    class Matches {
+      public:
+        void add(const ImageSynchronizer::Match& match) {
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _matches.push_back(match);
+            }
+            _cv.notify_all();
+        }
+
+        /// Wait until `count` matches were emitted and return them, in emission order.
+        std::vector<ImageSynchronizer::Match> wait_for(size_t count) {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _cv.wait_for(lock, std::chrono::seconds(5), [&] { return _matches.size() >= count; });
+            return _matches;
+        }
+
+      private:
+        std::mutex _mutex;
+        std::condition_variable _cv;
+        std::vector<ImageSynchronizer::Match> _matches;
+    };
+
+    class ImageSynchronizerTest : public testing::Test {
+      protected:
+        ImageSynchronizer::Options options() const {
+            ImageSynchronizer::Options options;
+            options.max_delay = 0.1;
+            options.max_buffered_images = 100;
+            options.emit_threads = 2;
+            return options;
+        }
+
+        tf2_ros::Buffer tf_buffer{ros::Duration(10.0), false};
+        Metrics metrics;
+        Matches matches;
+    };
+} // namespace
+
+TEST_F(ImageSynchronizerTest, KeepsTheOrderOfEachStream) {
+    ImageSynchronizer synchronizer(
+        options(), tf_buffer, "world", metrics, [&](const auto& match) { matches.add(match); }
+    );
+    const size_t images_per_stream = 50;
+    for (size_t i = 0; i < images_per_stream; ++i) {
+        const double stamp = 1.0 + 0.01 * i;
+        for (const std::string stream : {"/left", "/right", "/front"}) {
+            synchronizer.add_camera_info(stream, stream + "/camera_info", camera_info(stamp), "");
+            synchronizer.add_image(stream, stream + "/image", image(stamp), "", false);
+        }
+    }
+
+    std::map<std::string, std::vector<ros::Time>> stamps;
+    for (const auto& match : matches.wait_for(3 * images_per_stream)) {
+        ASSERT_TRUE(match.image);
+        stamps[match.image_topic].push_back(match.image->header.stamp);
+    }
+    ASSERT_EQ(stamps.size(), 3u);
+    for (const auto& [topic, topic_stamps] : stamps) {
+        ASSERT_EQ(topic_stamps.size(), images_per_stream) << topic;
+        for (size_t i = 1; i < topic_stamps.size(); ++i) {
+            EXPECT_LT(topic_stamps[i - 1], topic_stamps[i]) << topic;
+        }
+    }
+}
+
+TEST_F(ImageSynchronizerTest, PairsImagesWithTheNearestCameraInfo) {
+    ImageSynchronizer synchronizer(
+        options(), tf_buffer, "world", metrics, [&](const auto& match) { matches.add(match); }
+    );
+    synchronizer.add_camera_info("/camera", "/camera/camera_info", camera_info(0.99), "");
+    synchronizer.add_camera_info("/camera", "/camera/camera_info", camera_info(1.005), "");
+    synchronizer.add_camera_info("/camera", "/camera/camera_info", camera_info(1.1), "");
+    synchronizer.add_image("/camera", "/camera/image", image(1.0), "", false);
+
+    const auto emitted = matches.wait_for(1);
+    ASSERT_EQ(emitted.size(), 1u);
+    ASSERT_TRUE(emitted[0].camera_info);
+    EXPECT_EQ(emitted[0].camera_info->header.stamp, ros::Time(1.005));
+    EXPECT_EQ(emitted[0].camera_info_topic, "/camera/camera_info");
+    EXPECT_FALSE(emitted[0].transform);
+}
+
+TEST_F(ImageSynchronizerTest, ForwardsCameraInfoWithoutImages) {
+    ImageSynchronizer synchronizer(
+        options(), tf_buffer, "world", metrics, [&](const auto& match) { matches.add(match); }
+    );
+    synchronizer.add_camera_info("/lidar", "/lidar/camera_info", camera_info(1.0), "/lidar");
+
+    const auto emitted = matches.wait_for(1);
+    ASSERT_EQ(emitted.size(), 1u);
+    EXPECT_FALSE(emitted[0].image);
+    ASSERT_TRUE(emitted[0].camera_info);
+    EXPECT_EQ(emitted[0].camera_info_entity_path, "/lidar");
+}
+
+int main(int argc, char** argv) {
+    testing::InitGoogleTest(&argc, argv);
+    // the throttled warnings use ros::Time
+    ros::Time::init();
+    return RUN_ALL_TESTS();
+}
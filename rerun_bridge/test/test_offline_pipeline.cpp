@@ -0,0 +1,168 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <ros/serialization.h>
+#include <sensor_msgs/Imu.h>
+
+#include "offline_pipeline.hpp"
+
+namespace {
+    struct RecordedMessage {
+        std::string topic;
+        double receive_time;
+        std::string datatype = "sensor_msgs/Imu";
+    };
+
+    using RecordedPart = std::vector<RecordedMessage>;
+
+    std::vector<uint8_t> serialized_imu() {
+        sensor_msgs::Imu msg;
+        std::vector<uint8_t> data(ros::serialization::serializationLength(msg));
+        ros::serialization::OStream stream(data.data(), static_cast<uint32_t>(data.size()));
+        ros::serialization::serialize(stream, msg);
+        return data;
+    }
+
+    /// A source visiting the given messages of each part in the given order. Parts start at
+    /// their earliest message, empty ones where the previous part starts.
+    OfflineSource recorded_source(const std::vector<RecordedPart>& parts) {
+        OfflineSource source;
+        for (const auto& part : parts) {
+            double start = source.part_starts.empty() ? 0.0 : source.part_starts.back().toSec();
+            if (!part.empty()) {
+                start = part.front().receive_time;
+            }
+            for (const auto& message : part) {
+                start = std::min(start, message.receive_time);
+            }
+            source.part_starts.push_back(ros::Time(start));
+        }
+        auto shared_parts = std::make_shared<const std::vector<RecordedPart>>(parts);
+        auto data = std::make_shared<const std::vector<uint8_t>>(serialized_imu());
+        source.open_reader = [shared_parts, data]() -> OfflinePartReader {
+            return [shared_parts, data](size_t part, const OfflineVisitor& visit) {
+                for (const auto& message : (*shared_parts)[part]) {
+                    visit(
+                        message.topic,
+                        message.datatype,
+                        ros::Time(message.receive_time),
+                        data->data(),
+                        data->size()
+                    );
+                }
+            };
+        };
+        return source;
+    }
+
+    std::vector<ros::Time> times(const std::vector<double>& seconds) {
+        std::vector<ros::Time> times;
+        for (double time : seconds) {
+            times.emplace_back(time);
+        }
+        return times;
+    }
+
+    /// Receive times and topics in the order the messages were merged.
+    struct Merged {
+        std::vector<ros::Time> receive_times;
+        std::vector<std::string> topics;
+    };
+
+    Merged merge(const OfflineSource& source, size_t num_threads, size_t* num_messages = nullptr) {
+        Merged merged;
+        const size_t count = convert_offline(
+            source,
+            [&](const DecodedMessage& message) {
+                merged.receive_times.push_back(message.receive_time);
+                merged.topics.push_back(message.topic);
+            },
+            num_threads
+        );
+        if (num_messages != nullptr) {
+            *num_messages = count;
+        }
+        return merged;
+    }
+} // namespace
+
+class OfflinePipelineTest : public testing::TestWithParam<size_t> {};
+
+TEST_P(OfflinePipelineTest, MergesOverlappingPartsByReceiveTime) {
+    const auto source = recorded_source({
+        {{"/a", 1.0}, {"/a", 3.0}, {"/a", 5.0}, {"/a", 7.0}},
+        {{"/b", 2.0}, {"/b", 4.0}, {"/b", 6.0}},
+        {{"/c", 8.0}, {"/c", 9.0}},
+    });
+    size_t num_messages = 0;
+    const Merged merged = merge(source, GetParam(), &num_messages);
+    EXPECT_EQ(num_messages, 9u);
+    EXPECT_EQ(merged.receive_times, times({1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0, 8.0, 9.0}));
+}
+
+TEST_P(OfflinePipelineTest, SortsPartsVisitedOutOfOrder) {
+    const auto source = recorded_source({
+        {{"/a", 3.0}, {"/a", 1.0}, {"/a", 2.0}},
+        {{"/b", 5.0}, {"/b", 4.0}},
+    });
+    EXPECT_EQ(merge(source, GetParam()).receive_times, times({1.0, 2.0, 3.0, 4.0, 5.0}));
+}
+
+TEST_P(OfflinePipelineTest, BreaksTiesByPart) {
+    const auto source = recorded_source({
+        {{"/a", 1.0}, {"/a", 2.0}},
+        {{"/b", 1.0}, {"/b", 2.0}},
+    });
+    EXPECT_EQ(merge(source, GetParam()).topics, (std::vector<std::string>{"/a", "/b", "/a", "/b"}));
+}
+
+TEST_P(OfflinePipelineTest, MergesMorePartsThanFitInTheWindow) {
+    // each part overlaps the next one, so the merge always holds two parts
+    std::vector<RecordedPart> parts;
+    std::vector<double> expected;
+    for (int part = 0; part < 100; ++part) {
+        parts.push_back({{"/a", part + 0.0}, {"/a", part + 1.5}});
+        expected.push_back(part + 0.0);
+        expected.push_back(part + 1.5);
+    }
+    std::sort(expected.begin(), expected.end());
+    EXPECT_EQ(merge(recorded_source(parts), GetParam()).receive_times, times(expected));
+}
+
+TEST_P(OfflinePipelineTest, SkipsUnsupportedMessagesAndEmptyParts) {
+    const auto source = recorded_source({
+        {{"/a", 1.0}, {"/points", 1.5, "sensor_msgs/PointCloud2"}, {"/a", 2.0}},
+        {},
+        {{"/a", 3.0}},
+    });
+    size_t num_messages = 0;
+    const Merged merged = merge(source, GetParam(), &num_messages);
+    EXPECT_EQ(merged.receive_times, times({1.0, 2.0, 3.0}));
+    EXPECT_EQ(num_messages, 3u);
+}
+
+TEST_P(OfflinePipelineTest, ThrowsIfAPartCantBeRead) {
+    OfflineSource source = recorded_source({{{"/a", 1.0}}, {{"/a", 2.0}}});
+    source.open_reader = []() -> OfflinePartReader {
+        return [](size_t part, const OfflineVisitor&) {
+            if (part == 1) {
+                throw std::runtime_error("corrupt chunk");
+            }
+        };
+    };
+    EXPECT_THROW(merge(source, GetParam()), std::runtime_error);
+}
+
+INSTANTIATE_TEST_SUITE_P(Threads, OfflinePipelineTest, testing::Values(1, 4));
+
+int main(int argc, char** argv) {
+    testing::InitGoogleTest(&argc, argv);
+    // the throttled warnings use ros::Time
+    ros::Time::init();
+    return RUN_ALL_TESTS();
+}
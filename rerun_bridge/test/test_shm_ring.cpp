@@ -0,0 +1,171 @@
+#include <gtest/gtest.h>
+
+#include <unistd.h>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "shm_ring.hpp"
+
+namespace {
+    /// Unique per process, so concurrent test runs don't share rings.
+    std::string ring_name(const std::string& test) {
+        return "/rerun_bridge_test_" + test + "_" + std::to_string(getpid());
+    }
+
+    bool write(ShmRing& ring, uint32_t kind, const void* data, size_t size) {
+        ShmRing::Reservation reservation;
+        if (!ring.reserve(kind, size, reservation)) {
+            return false;
+        }
+        std::memcpy(reservation.data, data, size);
+        ring.commit(reservation);
+        return true;
+    }
+} // namespace
+
+TEST(ShmRing, OpensOnlyExistingRings) {
+    const std::string name = ring_name("open");
+    EXPECT_FALSE(ShmRing::open(name));
+    {
+        auto consumer = ShmRing::create(name, 4096);
+        auto producer = ShmRing::open(name);
+        ASSERT_TRUE(producer);
+        EXPECT_EQ(producer->generation(), consumer->generation());
+        EXPECT_TRUE(producer->consumer_alive());
+    }
+    // the consumer removes the ring
+    EXPECT_FALSE(ShmRing::open(name));
+}
+
+TEST(ShmRing, RecreatingChangesTheGeneration) {
+    const std::string name = ring_name("generation");
+    auto consumer = ShmRing::create(name, 4096);
+    auto producer = ShmRing::open(name);
+    ASSERT_TRUE(producer);
+    const uint64_t generation = producer->generation();
+
+    // a restarted consumer replaces the ring, the producer still has the old one mapped
+    consumer.reset();
+    consumer = ShmRing::create(name, 4096);
+    EXPECT_EQ(producer->generation(), generation);
+    auto reopened = ShmRing::open(name);
+    ASSERT_TRUE(reopened);
+    EXPECT_NE(reopened->generation(), generation);
+}
+
+TEST(ShmRing, ConsumesRecordsInOrderAcrossWrapArounds) {
+    const std::string name = ring_name("order");
+    auto consumer = ShmRing::create(name, 1024);
+    auto producer = ShmRing::open(name);
+    ASSERT_TRUE(producer);
+
+    // record sizes that don't divide the capacity, so records are padded at the end
+    uint32_t written = 0;
+    uint32_t consumed = 0;
+    for (int lap = 0; lap < 100; ++lap) {
+        for (int i = 0; i < 5; ++i, ++written) {
+            const std::vector<uint32_t> payload(1 + written % 23, written);
+            ASSERT_TRUE(write(*producer, 7, payload.data(), payload.size() * sizeof(uint32_t)));
+        }
+        consumer->consume(
+            [&](uint32_t kind, const uint8_t* data, size_t size) {
+                EXPECT_EQ(kind, 7u);
+                EXPECT_EQ(size, (1 + consumed % 23) * sizeof(uint32_t));
+                uint32_t value;
+                std::memcpy(&value, data, sizeof(value));
+                EXPECT_EQ(value, consumed);
+                ++consumed;
+            },
+            1000
+        );
+    }
+    EXPECT_EQ(consumed, written);
+    EXPECT_EQ(consumer->dropped(), 0u);
+}
+
+TEST(ShmRing, DropsRecordsThatDontFit) {
+    const std::string name = ring_name("full");
+    auto consumer = ShmRing::create(name, 256);
+    auto producer = ShmRing::open(name);
+    ASSERT_TRUE(producer);
+
+    const std::vector<uint8_t> payload(100, 1);
+    EXPECT_TRUE(write(*producer, 1, payload.data(), payload.size()));
+    EXPECT_TRUE(write(*producer, 1, payload.data(), payload.size()));
+    EXPECT_FALSE(write(*producer, 1, payload.data(), payload.size()));
+    const std::vector<uint8_t> too_large(512, 1);
+    EXPECT_FALSE(write(*producer, 1, too_large.data(), too_large.size()));
+    EXPECT_EQ(consumer->dropped(), 2u);
+
+    // consuming frees the space again
+    EXPECT_EQ(consumer->consume([](uint32_t, const uint8_t*, size_t) {}, 10), 2u);
+    EXPECT_TRUE(write(*producer, 1, payload.data(), payload.size()));
+}
+
+TEST(ShmRing, UncommittedRecordsBlockLaterOnes) {
+    const std::string name = ring_name("commit");
+    auto consumer = ShmRing::create(name, 1024);
+    auto producer = ShmRing::open(name);
+    ASSERT_TRUE(producer);
+
+    ShmRing::Reservation first;
+    ASSERT_TRUE(producer->reserve(1, 8, first));
+    const uint64_t value = 2;
+    ASSERT_TRUE(write(*producer, 2, &value, sizeof(value)));
+
+    auto consume_kinds = [&] {
+        std::vector<uint32_t> kinds;
+        consumer->consume(
+            [&](uint32_t kind, const uint8_t*, size_t) { kinds.push_back(kind); }, 10
+        );
+        return kinds;
+    };
+    EXPECT_TRUE(consume_kinds().empty());
+    producer->commit(first);
+    EXPECT_EQ(consume_kinds(), (std::vector<uint32_t>{1, 2}));
+}
+
+TEST(ShmRing, ConcurrentProducersLoseNothing) {
+    const std::string name = ring_name("concurrent");
+    auto consumer = ShmRing::create(name, 64 * 1024);
+
+    const uint32_t num_producers = 4;
+    const uint32_t records_per_producer = 20000;
+    std::vector<std::thread> producers;
+    for (uint32_t p = 0; p < num_producers; ++p) {
+        producers.emplace_back([&, p] {
+            auto producer = ShmRing::open(name);
+            for (uint32_t i = 0; i < records_per_producer; ++i) {
+                const uint32_t record[2] = {p, i};
+                // the consumer is never far behind, retry until there's space
+                while (!write(*producer, 1, record, sizeof(record))) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    // records of each producer arrive in the order it wrote them
+    std::vector<uint32_t> next(num_producers, 0);
+    uint32_t consumed = 0;
+    while (consumed < num_producers * records_per_producer) {
+        consumed += static_cast<uint32_t>(consumer->consume(
+            [&](uint32_t, const uint8_t* data, size_t size) {
+                ASSERT_EQ(size, 2 * sizeof(uint32_t));
+                uint32_t record[2];
+                std::memcpy(record, data, sizeof(record));
+                ASSERT_LT(record[0], num_producers);
+                EXPECT_EQ(record[1], next[record[0]]++);
+            },
+            1000
+        ));
+    }
+    for (auto& producer : producers) {
+        producer.join();
+    }
+    for (uint32_t p = 0; p < num_producers; ++p) {
+        EXPECT_EQ(next[p], records_per_producer);
+    }
+}
@@ -0,0 +1,156 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <vector>
+
+#include "tf_cache.hpp"
+
+namespace {
+    /// A transform from "odom" to "body" at `stamp`, translated along x and rotated about z.
+    geometry_msgs::TransformStamped transform(double stamp, double x, double yaw) {
+        geometry_msgs::TransformStamped transform;
+        transform.header.stamp = ros::Time(stamp);
+        transform.header.frame_id = "odom";
+        transform.child_frame_id = "body";
+        transform.transform.translation.x = x;
+        transform.transform.translation.y = 0.0;
+        transform.transform.translation.z = 0.0;
+        transform.transform.rotation.x = 0.0;
+        transform.transform.rotation.y = 0.0;
+        transform.transform.rotation.z = std::sin(0.5 * yaw);
+        transform.transform.rotation.w = std::cos(0.5 * yaw);
+        return transform;
+    }
+
+    double yaw(const TfSamples& samples, size_t i) {
+        return 2.0 * std::atan2(samples.qz[i], samples.qw[i]);
+    }
+} // namespace
+
+TEST(TfCache, InterpolatesBetweenTheBracketingSamples) {
+    TfCache cache;
+    const std::vector<size_t> slots = {cache.slot("odom", "body")};
+    cache.add(transform(10.0, 0.0, 0.0));
+    cache.add(transform(10.1, 1.0, M_PI / 2.0));
+    cache.add(transform(10.2, 3.0, M_PI / 2.0));
+
+    TfSamples samples;
+    cache.interpolate(slots, ros::Time(10.025), samples);
+    ASSERT_TRUE(samples.valid[0]);
+    EXPECT_NEAR(samples.tx[0], 0.25, 1e-9);
+    // SLERP rotates at a constant rate, unlike normalized LERP
+    EXPECT_NEAR(yaw(samples, 0), M_PI / 8.0, 1e-9);
+    EXPECT_NEAR(std::hypot(samples.qz[0], samples.qw[0]), 1.0, 1e-9);
+
+    cache.interpolate(slots, ros::Time(10.15), samples);
+    ASSERT_TRUE(samples.valid[0]);
+    EXPECT_NEAR(samples.tx[0], 2.0, 1e-9);
+    EXPECT_NEAR(yaw(samples, 0), M_PI / 2.0, 1e-9);
+
+    // exactly at a sample
+    cache.interpolate(slots, ros::Time(10.1), samples);
+    ASSERT_TRUE(samples.valid[0]);
+    EXPECT_NEAR(samples.tx[0], 1.0, 1e-9);
+}
+
+TEST(TfCache, TakesTheShorterArc) {
+    TfCache cache;
+    const std::vector<size_t> slots = {cache.slot("odom", "body")};
+    auto first = transform(1.0, 0.0, 0.0);
+    auto second = transform(2.0, 0.0, M_PI / 2.0);
+    // the same rotation with the opposite sign
+    second.transform.rotation.z = -second.transform.rotation.z;
+    second.transform.rotation.w = -second.transform.rotation.w;
+    cache.add(first);
+    cache.add(second);
+
+    TfSamples samples;
+    cache.interpolate(slots, ros::Time(1.5), samples);
+    ASSERT_TRUE(samples.valid[0]);
+    EXPECT_NEAR(std::abs(yaw(samples, 0)), M_PI / 4.0, 1e-9);
+}
+
+TEST(TfCache, KeepsRotationsUnitLength) {
+    TfCache cache;
+    const std::vector<size_t> slots = {cache.slot("odom", "body"), cache.slot("odom", "head")};
+    // nearly identical rotations and a large step between two samples
+    cache.add(transform(1.0, 0.0, 0.3));
+    cache.add(transform(2.0, 0.0, 0.3 + 1e-8));
+    auto head = [](double stamp, double yaw) {
+        auto head = transform(stamp, 0.0, yaw);
+        head.child_frame_id = "head";
+        return head;
+    };
+    cache.add(head(1.0, 0.0));
+    cache.add(head(2.0, 3.0));
+
+    TfSamples samples;
+    for (double time = 1.0; time <= 2.0; time += 0.125) {
+        cache.interpolate(slots, ros::Time(time), samples);
+        for (size_t i = 0; i < slots.size(); ++i) {
+            ASSERT_TRUE(samples.valid[i]);
+            const double norm = std::sqrt(
+                samples.qx[i] * samples.qx[i] + samples.qy[i] * samples.qy[i] +
+                samples.qz[i] * samples.qz[i] + samples.qw[i] * samples.qw[i]
+            );
+            EXPECT_NEAR(norm, 1.0, 1e-12);
+        }
+        EXPECT_NEAR(yaw(samples, 0), 0.3, 1e-8);
+        // the SLERP approximation is least accurate for steps of close to 180 degrees
+        EXPECT_NEAR(yaw(samples, 1), 3.0 * (time - 1.0), 1e-7);
+    }
+}
+
+TEST(TfCache, MarksTimesOutsideTheSamplesInvalid) {
+    TfCache cache;
+    const std::vector<size_t> slots = {cache.slot("odom", "body"), cache.slot("odom", "arm")};
+    cache.add(transform(1.0, 0.0, 0.0));
+    cache.add(transform(2.0, 1.0, 0.0));
+
+    TfSamples samples;
+    cache.interpolate(slots, ros::Time(0.5), samples);
+    EXPECT_FALSE(samples.valid[0]);
+    cache.interpolate(slots, ros::Time(2.5), samples);
+    EXPECT_FALSE(samples.valid[0]);
+    // an edge without any samples
+    cache.interpolate(slots, ros::Time(1.5), samples);
+    EXPECT_TRUE(samples.valid[0]);
+    EXPECT_FALSE(samples.valid[1]);
+}
+
+TEST(TfCache, IgnoresEdgesThatAreNotLookedUpAndOutOfOrderSamples) {
+    TfCache cache;
+    auto unknown = transform(1.0, 0.0, 0.0);
+    unknown.child_frame_id = "camera";
+    cache.add(unknown);
+
+    const std::vector<size_t> slots = {cache.slot("odom", "body")};
+    cache.add(transform(1.0, 0.0, 0.0));
+    cache.add(transform(2.0, 1.0, 0.0));
+    cache.add(transform(1.5, 5.0, 0.0));
+
+    TfSamples samples;
+    cache.interpolate(slots, ros::Time(1.5), samples);
+    ASSERT_TRUE(samples.valid[0]);
+    EXPECT_NEAR(samples.tx[0], 0.5, 1e-9);
+}
+
+TEST(TfCache, GrowsAndTrimsTheHistory) {
+    TfCache cache(1.0);
+    const std::vector<size_t> slots = {cache.slot("odom", "body")};
+    // 1 kHz for 3 s, many times the initial capacity and wrapping around after trimming
+    for (int i = 0; i <= 3000; ++i) {
+        cache.add(transform(100.0 + i * 0.001, i, 0.0));
+    }
+
+    TfSamples samples;
+    cache.interpolate(slots, ros::Time(102.5005), samples);
+    ASSERT_TRUE(samples.valid[0]);
+    EXPECT_NEAR(samples.tx[0], 2500.5, 1e-6);
+    // one sample before the history is kept to bracket its start
+    cache.interpolate(slots, ros::Time(101.9995), samples);
+    ASSERT_TRUE(samples.valid[0]);
+    EXPECT_NEAR(samples.tx[0], 1999.5, 1e-6);
+    cache.interpolate(slots, ros::Time(101.5), samples);
+    EXPECT_FALSE(samples.valid[0]);
+}
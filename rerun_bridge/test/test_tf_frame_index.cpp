@@ -0,0 +1,80 @@
+#include <gtest/gtest.h>
+
+#include <yaml-cpp/yaml.h>
+
+#include "tf_frame_index.hpp"
+
+TEST(TfFrameIndex, MapsTheConfiguredTree) {
+    TfFrameIndex frames;
+    frames.add_tree(YAML::Load("{odom: {body: {front_rail: {}, rear_rail: {}}}}"));
+
+    EXPECT_EQ(frames.size(), 4u);
+    EXPECT_EQ(frames.entity_path("odom", ""), "/odom");
+    EXPECT_EQ(frames.entity_path("front_rail", "body"), "/odom/body/front_rail");
+    EXPECT_EQ(frames.entity_path("rear_rail", "body"), "/odom/body/rear_rail");
+    // without discovery, unknown frames have no entity path
+    EXPECT_EQ(frames.entity_path("camera", "body"), "");
+    EXPECT_EQ(frames.size(), 4u);
+}
+
+TEST(TfFrameIndex, DiscoversFramesBelowTheirParent) {
+    TfFrameIndex frames;
+    frames.set_discover(true);
+    frames.add_tree(YAML::Load("{odom: {body: {}}}"));
+
+    EXPECT_EQ(frames.entity_path("camera", "body"), "/odom/body/camera");
+    EXPECT_EQ(frames.entity_path("lens", "camera"), "/odom/body/camera/lens");
+    // unknown parents become roots
+    EXPECT_EQ(frames.entity_path("arm", "arm_base"), "/arm_base/arm");
+    EXPECT_EQ(frames.entity_path("arm_base", ""), "/arm_base");
+}
+
+TEST(TfFrameIndex, MovesTheSubtreeOfARootThatGetsAParent) {
+    TfFrameIndex frames;
+    frames.set_discover(true);
+    frames.add_tree(YAML::Load("{odom: {body: {}}}"));
+
+    // the arm's transforms arrive before the one attaching it to the body
+    EXPECT_EQ(frames.entity_path("gripper", "arm"), "/arm/gripper");
+    EXPECT_EQ(frames.entity_path("arm", "arm_base"), "/arm_base/arm");
+    const uint64_t version = frames.version();
+
+    EXPECT_EQ(frames.entity_path("arm_base", "body"), "/odom/body/arm_base");
+    EXPECT_NE(frames.version(), version);
+    EXPECT_EQ(frames.entity_path("arm", "arm_base"), "/odom/body/arm_base/arm");
+    EXPECT_EQ(frames.entity_path("gripper", "arm"), "/odom/body/arm_base/arm/gripper");
+
+    const auto entity_paths = frames.entity_paths();
+    EXPECT_EQ(entity_paths.at("arm_base"), "/odom/body/arm_base");
+    EXPECT_EQ(entity_paths.at("gripper"), "/odom/body/arm_base/arm/gripper");
+}
+
+TEST(TfFrameIndex, KeepsTheFirstParentOfAFrame) {
+    TfFrameIndex frames;
+    frames.set_discover(true);
+    EXPECT_EQ(frames.entity_path("camera", "body"), "/body/camera");
+    EXPECT_EQ(frames.entity_path("camera", "head"), "/body/camera");
+}
+
+TEST(TfFrameIndex, DoesntMoveAFrameBelowItsDescendant) {
+    TfFrameIndex frames;
+    frames.set_discover(true);
+    EXPECT_EQ(frames.entity_path("b", "a"), "/a/b");
+    // a cycle, `a` is a root with `b` below it
+    EXPECT_EQ(frames.entity_path("a", "b"), "/a");
+    EXPECT_EQ(frames.entity_path("b", "a"), "/a/b");
+}
+
+TEST(TfFrameIndex, SkipsStaticFramesWhenVisitingDynamicOnes) {
+    TfFrameIndex frames;
+    frames.add_tree(YAML::Load("{odom: {body: {camera: {}}}}"));
+    frames.set_static("camera");
+
+    std::vector<std::string> visited;
+    frames.for_each_dynamic_frame(
+        [&](const std::string& frame, const std::string& parent_frame, const std::string&) {
+            visited.push_back(parent_frame + "->" + frame);
+        }
+    );
+    EXPECT_EQ(visited, std::vector<std::string>{"odom->body"});
+}